@@ -0,0 +1,202 @@
+#include "async_writer.h"
+
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+AsyncWriter::AsyncWriter(int fd, int buffers, size_t buffer_size) : fd_(fd), ring_fd_(-1), buffers_(nullptr),
+                                                                    buffer_count_(std::max(1, buffers)),
+                                                                    buffer_size_(buffer_size), head_(0), queued_(0),
+                                                                    in_flight_(false), failed_(false),
+                                                                    sq_ring_(MAP_FAILED), cq_ring_(MAP_FAILED),
+                                                                    sq_ring_size_(0),
+                                                                    cq_ring_size_(0), sqes_(nullptr), sqes_size_(0),
+                                                                    sq_tail_(nullptr), sq_mask_(nullptr),
+                                                                    sq_array_(nullptr), cq_head_(nullptr),
+                                                                    cq_tail_(nullptr), cq_mask_(nullptr),
+                                                                    cqes_(nullptr) {
+    if (fd_ < 0) {
+        return;
+    }
+    setup();
+    if (ring_fd_ < 0) {
+        return;
+    }
+    buffers_ = new Buffer[buffer_count_];
+    for (int i = 0; i < buffer_count_; ++i) {
+        buffers_[i] = {new char[buffer_size_], 0, 0};
+    }
+}
+
+AsyncWriter::~AsyncWriter() {
+    drain();
+    if (sqes_ != nullptr) {
+        munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+        munmap(sq_ring_, sq_ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+        close(ring_fd_);
+    }
+    for (int i = 0; buffers_ != nullptr && i < buffer_count_; ++i) {
+        delete[] buffers_[i].data_;
+    }
+    delete[] buffers_;
+}
+
+void AsyncWriter::setup() {
+    io_uring_params params{};
+    int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, 2, &params));
+    if (ring_fd < 0) {
+        return;
+    }
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        // a pipe has no offset, and a file is written at its current position like write(2)
+        close(ring_fd);
+        return;
+    }
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                    IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap || sq_ring_ == MAP_FAILED ? sq_ring_ :
+               mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                    IORING_OFF_CQ_RING);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                      IORING_OFF_SQES);
+    if (sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size_);
+        }
+        if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+            munmap(cq_ring_, cq_ring_size_);
+        }
+        if (sq_ring_ != MAP_FAILED) {
+            munmap(sq_ring_, sq_ring_size_);
+        }
+        sq_ring_ = cq_ring_ = MAP_FAILED;
+        close(ring_fd);
+        return;
+    }
+    auto *sq_ring = static_cast<char *>(sq_ring_);
+    auto *cq_ring = static_cast<char *>(cq_ring_);
+    sqes_ = static_cast<io_uring_sqe *>(sqes);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq_ring + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq_ring + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq_ring + params.cq_off.cqes);
+    ring_fd_ = ring_fd;
+}
+
+void AsyncWriter::write(const char *data, size_t size) {
+    if (ring_fd_ < 0) {
+        writeNow(data, size);
+        return;
+    }
+    while (size > 0) {
+        // handle the completed writes, and wait for one only if every buffer is waiting to be written
+        reap(queued_ == buffer_count_);
+        if (failed_) {
+            return;
+        }
+        Buffer &buffer = buffers_[(head_ + queued_) % buffer_count_];
+        size_t length = std::min(size, buffer_size_);
+        memcpy(buffer.data_, data, length);
+        buffer.size_ = length;
+        buffer.written_ = 0;
+        ++queued_;
+        data += length;
+        size -= length;
+        if (!in_flight_) {
+            submit();
+        }
+    }
+}
+
+void AsyncWriter::drain() {
+    while (in_flight_) {
+        reap(true);
+    }
+}
+
+void AsyncWriter::submit() {
+    const Buffer &buffer = buffers_[head_];
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe &sqe = sqes_[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_WRITE;
+    sqe.fd = fd_;
+    sqe.addr = reinterpret_cast<unsigned long long>(buffer.data_ + buffer.written_);
+    sqe.len = static_cast<unsigned>(buffer.size_ - buffer.written_);
+    sqe.off = static_cast<unsigned long long>(-1); // the current position
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0 && errno == EINTR);
+    in_flight_ = true;
+}
+
+void AsyncWriter::reap(bool wait) {
+    while (in_flight_) {
+        unsigned head = *cq_head_;
+        if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+            if (!wait) {
+                return;
+            }
+            syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            continue;
+        }
+        int result = cqes_[head & *cq_mask_].res;
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        in_flight_ = false;
+        Buffer &buffer = buffers_[head_];
+        if (result > 0) {
+            buffer.written_ += result;
+        } else if (result != -EINTR) {
+            // drop the rest of the output, like write(2) in OutputBuffer
+            failed_ = true;
+            queued_ = 0;
+            return;
+        }
+        if (buffer.written_ == buffer.size_) {
+            // the buffer is free, which is enough for the caller waiting for one
+            head_ = (head_ + 1) % buffer_count_;
+            --queued_;
+            wait = false;
+        }
+        if (queued_ > 0) {
+            // the rest of the buffer after a short write, or the next buffer
+            submit();
+        }
+    }
+}
+
+void AsyncWriter::writeNow(const char *data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        ssize_t ret = ::write(fd_, data + written, size - written);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        written += ret;
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef ACM_ICPC_MANAGEMENT_ASYNC_WRITER_H
+#define ACM_ICPC_MANAGEMENT_ASYNC_WRITER_H
+
+#include <cstddef>
+
+#include "output_buffer.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * @brief The class of asynchronous writer
+ * @details The class of asynchronous writer, an output writer submitting the filled output to io_uring from a ring of preallocated buffers, so the caller does not wait for a slow pipe or file.
+ * The data is copied into the free buffers, which are written in order by one write request at a time, so the output keeps its order even on a pipe, and a short write continues from where it stopped.
+ * The caller only blocks when every buffer is waiting to be written.
+ * io_uring is set up with raw system calls, and if the kernel does not support it, or does not support writing at the current file position, the data is written with write(2) at once.
+ */
+class AsyncWriter : public OutputWriter {
+public:
+    /**
+     * @brief Construct a new AsyncWriter object
+     * @param fd the file descriptor to write to, -1 for a writer which is never used, and sets nothing up
+     * @param buffers the number of buffers
+     * @param buffer_size the size of each buffer
+     */
+    explicit AsyncWriter(int fd, int buffers = kDefaultBuffers, size_t buffer_size = kDefaultBufferSize);
+
+    AsyncWriter(const AsyncWriter &) = delete;
+
+    AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+    /**
+     * @brief Destroy the AsyncWriter object
+     * @details Wait until all the data is written, then release the ring and the buffers
+     */
+    ~AsyncWriter() override;
+
+    /**
+     * @brief Copy the data into the free buffers and submit them
+     * @details Block only if there is no free buffer, until a write completes
+     */
+    void write(const char *data, size_t size) override;
+
+    /**
+     * @brief Wait until all the data is written
+     */
+    void drain();
+
+    /**
+     * @brief Check whether io_uring is used, false if falling back to write(2)
+     */
+    bool asynchronous() const {
+        return ring_fd_ >= 0;
+    }
+
+private:
+    static const int kDefaultBuffers = 8;
+    static const size_t kDefaultBufferSize = 1 << 16;
+
+    /**
+     * @brief The struct of buffer
+     *
+     * @param data_ The data
+     * @param size_ The number of bytes to write
+     * @param written_ The number of bytes written
+     */
+    struct Buffer {
+        char *data_;
+        size_t size_;
+        size_t written_;
+    };
+
+    int fd_; // the file descriptor to write to
+    int ring_fd_; // the file descriptor of io_uring, -1 if falling back to write(2)
+    Buffer *buffers_; // the buffers, nullptr if falling back to write(2)
+    int buffer_count_; // the number of buffers
+    size_t buffer_size_; // the size of each buffer
+    int head_; // the first buffer waiting to be written, the buffers are filled and written in circular order
+    int queued_; // the number of buffers waiting to be written
+    bool in_flight_; // whether the first waiting buffer is submitted and not completed
+    bool failed_; // whether a write has failed, after which the output is dropped like write(2) in OutputBuffer
+
+    void *sq_ring_; // the mapping of the submission queue ring
+    void *cq_ring_; // the mapping of the completion queue ring, the same as sq_ring_ with a single mapping
+    size_t sq_ring_size_; // the size of the mapping of the submission queue ring
+    size_t cq_ring_size_; // the size of the mapping of the completion queue ring
+    io_uring_sqe *sqes_; // the submission queue entries
+    size_t sqes_size_; // the size of the mapping of the submission queue entries
+    unsigned *sq_tail_; // the tail of the submission queue, written by us
+    unsigned *sq_mask_; // the mask of the submission queue
+    unsigned *sq_array_; // the array of the submission queue, the indices of the entries
+    unsigned *cq_head_; // the head of the completion queue, written by us
+    unsigned *cq_tail_; // the tail of the completion queue, written by the kernel
+    unsigned *cq_mask_; // the mask of the completion queue
+    io_uring_cqe *cqes_; // the completion queue entries
+
+    /**
+     * @brief Set up io_uring, and leave ring_fd_ -1 if it is not supported
+     */
+    void setup();
+
+    /**
+     * @brief Submit a write request of the rest of the first waiting buffer
+     */
+    void submit();
+
+    /**
+     * @brief Handle the completed write requests
+     * @param wait whether to wait for a completion if there is none
+     */
+    void reap(bool wait);
+
+    /**
+     * @brief Write the data with write(2) at once
+     */
+    void writeNow(const char *data, size_t size);
+};
+
+#endif //ACM_ICPC_MANAGEMENT_ASYNC_WRITER_H
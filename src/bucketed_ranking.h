@@ -0,0 +1,174 @@
+#ifndef ACM_ICPC_MANAGEMENT_BUCKETED_RANKING_H
+#define ACM_ICPC_MANAGEMENT_BUCKETED_RANKING_H
+
+#include <cstddef>
+
+#include "ranking_tree.h"
+
+/**
+ * @brief The class of bucketed ranking
+ * @details The class of bucketed ranking, a set of values split into buckets by the high half of their keys, such as the number of accepted problems, with one ranking tree per bucket.
+ * A value only moves between a few buckets, so each tree stays small, and the number of values in the buckets before each bucket is kept, so the rank of a value is that prefix plus its rank in its bucket.
+ *
+ * @tparam Value the type of the values, such as a pointer
+ * @tparam Compare the functor comparing two values, with a static getKey packing a value into its key, whose high 32 bits are the bucket in [0, kBuckets)
+ * @tparam kBuckets the number of buckets
+ */
+template<typename Value, typename Compare, int kBuckets>
+class BucketedRanking {
+    using Tree = RankingTree<Value, Compare>;
+
+public:
+    /**
+     * @brief The class of iterator, which walks the buckets in order
+     */
+    class Iterator {
+    public:
+        Iterator(const BucketedRanking *ranking, int bucket, typename Tree::Iterator position) : ranking_(ranking),
+                                                                                                 bucket_(bucket),
+                                                                                                 position_(position) {
+            skipEmpty();
+        }
+
+        Value operator*() const {
+            return *position_;
+        }
+
+        Iterator &operator++() {
+            ++position_;
+            skipEmpty();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const {
+            return bucket_ == other.bucket_ && position_ == other.position_;
+        }
+
+        bool operator!=(const Iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const BucketedRanking *ranking_; // the ranking
+        int bucket_; // the bucket, kBuckets for the end
+        typename Tree::Iterator position_; // the position in the bucket
+
+        void skipEmpty() {
+            while (bucket_ < kBuckets && position_ == ranking_->buckets_[bucket_].end()) {
+                if (++bucket_ < kBuckets) {
+                    position_ = ranking_->buckets_[bucket_].begin();
+                }
+            }
+        }
+    };
+
+    BucketedRanking() : ahead_(), size_(0) {}
+
+    Iterator begin() const {
+        return Iterator(this, 0, buckets_[0].begin());
+    }
+
+    Iterator end() const {
+        return Iterator(this, kBuckets, buckets_[0].end());
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    /**
+     * @brief Insert a value, which is not in the set
+     */
+    void insert(Value value) {
+        int bucket = getBucket(value);
+        buckets_[bucket].insert(value);
+        for (int i = bucket + 1; i < kBuckets; ++i) {
+            ++ahead_[i];
+        }
+        ++size_;
+    }
+
+    /**
+     * @brief Build the set from sorted values, in O(count) time
+     * @details The set must be empty, and the values must be in increasing order without equal ones, so the values of each bucket are a contiguous run, which builds its tree
+     * @param count the number of values
+     * @param get the function returning the value at an index in [0, count)
+     */
+    template<typename Function>
+    void build(size_t count, Function get) {
+        size_t begin = 0;
+        while (begin < count) {
+            int bucket = getBucket(get(begin));
+            size_t end = begin + 1;
+            while (end < count && getBucket(get(end)) == bucket) {
+                ++end;
+            }
+            buckets_[bucket].build(end - begin, [&get, begin](size_t index) {
+                return get(begin + index);
+            });
+            for (int i = bucket + 1; i < kBuckets; ++i) {
+                ahead_[i] += end - begin;
+            }
+            begin = end;
+        }
+        size_ = count;
+    }
+
+    /**
+     * @brief Erase a value, which is in the set with the same key as it was inserted
+     */
+    void erase(Value value) {
+        int bucket = getBucket(value);
+        size_t size = buckets_[bucket].size();
+        buckets_[bucket].erase(value);
+        if (buckets_[bucket].size() == size) {
+            return;
+        }
+        for (int i = bucket + 1; i < kBuckets; ++i) {
+            --ahead_[i];
+        }
+        --size_;
+    }
+
+    /**
+     * @brief Find the first value greater than a value, which is usually not in the set
+     */
+    Iterator upperBound(Value value) const {
+        int bucket = getBucket(value);
+        return Iterator(this, bucket, buckets_[bucket].upperBound(value));
+    }
+
+    /**
+     * @brief Get the number of values less than a value
+     */
+    size_t rank(Value value) const {
+        int bucket = getBucket(value);
+        return ahead_[bucket] + buckets_[bucket].rank(value);
+    }
+
+    /**
+     * @brief Find the value at a position in the order, starting from 0
+     * @return The iterator to the value, end() if the position is not less than size()
+     */
+    Iterator at(size_t position) const {
+        if (position >= size_) {
+            return end();
+        }
+        int bucket = 0;
+        while (position >= ahead_[bucket] + buckets_[bucket].size()) {
+            ++bucket;
+        }
+        return Iterator(this, bucket, buckets_[bucket].at(position - ahead_[bucket]));
+    }
+
+private:
+    Tree buckets_[kBuckets]; // the ranking tree of each bucket
+    size_t ahead_[kBuckets]; // the number of values in the buckets before each bucket
+    size_t size_; // the number of values
+
+    static int getBucket(Value value) {
+        return static_cast<int>(Compare::getKey(value) >> 32);
+    }
+};
+
+#endif //ACM_ICPC_MANAGEMENT_BUCKETED_RANKING_H
@@ -0,0 +1,54 @@
+#include "command_pipeline.h"
+
+#include <thread>
+
+#include "line_reader.h"
+
+void CommandPipeline::run() {
+    std::thread parser(&CommandPipeline::parse, this);
+    std::thread formatter(&CommandPipeline::format, this);
+    RingSink sink(results_);
+    system_.setResultSink(&sink);
+    while (true) {
+        const ICPCManagementSystem::Command &command = commands_.beginPop();
+        bool running = system_.execute(command);
+        commands_.commitPop();
+        if (!running) {
+            break;
+        }
+    }
+    ICPCManagementSystem::Result &end = results_.beginPush();
+    end.type_ = ICPCManagementSystem::Result::kEnd;
+    results_.commitPush();
+    parser.join();
+    formatter.join();
+}
+
+void CommandPipeline::parse() {
+    LineReader reader(input_fd_);
+    while (const char *line = reader.readLine()) {
+        ICPCManagementSystem::Command &command = commands_.beginPush();
+        if (ICPCManagementSystem::parseCommand(line, command)) {
+            commands_.commitPush();
+            if (command.type_ == ICPCManagementSystem::Command::kEnd) {
+                return;
+            }
+        }
+    }
+    ICPCManagementSystem::Command &command = commands_.beginPush();
+    command.type_ = ICPCManagementSystem::Command::kEndOfInput;
+    commands_.commitPush();
+}
+
+void CommandPipeline::format() {
+    OutputBuffer output(output_fd_);
+    while (true) {
+        const ICPCManagementSystem::Result &result = results_.beginPop();
+        if (result.type_ == ICPCManagementSystem::Result::kEnd) {
+            results_.commitPop();
+            break;
+        }
+        ICPCManagementSystem::formatResult(result, output);
+        results_.commitPop();
+    }
+}
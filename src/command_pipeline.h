@@ -0,0 +1,68 @@
+#ifndef ACM_ICPC_MANAGEMENT_COMMAND_PIPELINE_H
+#define ACM_ICPC_MANAGEMENT_COMMAND_PIPELINE_H
+
+#include "icpc_management_system.h"
+#include "spsc_ring.h"
+
+/**
+ * @brief The class of command pipeline
+ * @details The class of command pipeline, which runs the commands from an input file descriptor in three stages on three threads:
+ * the parser thread reads the input and parses the command lines into commands, the engine thread executes the commands and emits the result records, and the formatter thread renders the records and writes them to the output file descriptor.
+ * The stages are connected by SPSC ring buffers, so the order of the commands and the output is preserved.
+ */
+class CommandPipeline {
+public:
+    /**
+     * @brief Construct a new CommandPipeline object
+     * @param system the system to execute the commands
+     * @param input_fd the file descriptor to read the commands from
+     * @param output_fd the file descriptor to write the output to
+     */
+    CommandPipeline(ICPCManagementSystem &system, int input_fd, int output_fd) : system_(system), input_fd_(input_fd),
+                                                                               output_fd_(output_fd),
+                                                                               commands_(kCommandRingSize),
+                                                                               results_(kResultRingSize) {}
+
+    /**
+     * @brief Run the pipeline until END or the end of the input
+     * @details The engine stage runs on the calling thread
+     */
+    void run();
+
+private:
+    static const size_t kCommandRingSize = 1 << 12; // the capacity of the ring between the parser and the engine
+    static const size_t kResultRingSize = 1 << 12; // the capacity of the ring between the engine and the formatter
+
+    /**
+     * @brief The result sink pushing the records into the ring of the formatter
+     */
+    class RingSink : public ICPCManagementSystem::ResultSink {
+    public:
+        explicit RingSink(SpscRing<ICPCManagementSystem::Result> &ring) : ring_(ring) {}
+
+        void put(const ICPCManagementSystem::Result &result) override {
+            ring_.push(result);
+        }
+
+    private:
+        SpscRing<ICPCManagementSystem::Result> &ring_;
+    };
+
+    ICPCManagementSystem &system_; // the system to execute the commands
+    int input_fd_; // the file descriptor to read the commands from
+    int output_fd_; // the file descriptor to write the output to
+    SpscRing<ICPCManagementSystem::Command> commands_; // the ring between the parser and the engine
+    SpscRing<ICPCManagementSystem::Result> results_; // the ring between the engine and the formatter
+
+    /**
+     * @brief The parser stage, reading and parsing until END or the end of the input
+     */
+    void parse();
+
+    /**
+     * @brief The formatter stage, rendering and writing until the end of the records
+     */
+    void format();
+};
+
+#endif //ACM_ICPC_MANAGEMENT_COMMAND_PIPELINE_H
@@ -0,0 +1,141 @@
+#include "contest_router.h"
+
+#include <cstring>
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "line_reader.h"
+
+ContestRouter::ContestRouter(int input_fd, int output_fd, int workers) : input_fd_(input_fd), output_fd_(output_fd) {
+    for (int i = 0; i < workers; ++i) {
+        workers_.push_back(new Worker());
+    }
+}
+
+ContestRouter::~ContestRouter() {
+    for (Worker *worker: workers_) {
+        for (Contest *contest: worker->contests_) {
+            delete contest;
+        }
+        delete worker;
+    }
+}
+
+void ContestRouter::run() {
+    // pin the workers to the cores in the affinity mask in turn
+    std::vector<int> cores;
+    cpu_set_t core_set;
+    if (sched_getaffinity(0, sizeof(core_set), &core_set) == 0) {
+        for (int core = 0; core < CPU_SETSIZE; ++core) {
+            if (CPU_ISSET(core, &core_set)) {
+                cores.push_back(core);
+            }
+        }
+    }
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        int core = cores.empty() ? -1 : cores[i % cores.size()];
+        workers_[i]->thread_ = std::thread(&ContestRouter::runWorker, this, workers_[i], core);
+    }
+
+    LineReader reader(input_fd_);
+    const char *line;
+    while ((line = reader.readLine()) != nullptr && route(line));
+
+    for (Worker *worker: workers_) {
+        worker->tasks_.beginPush().contest_ = nullptr;
+        worker->tasks_.commitPush();
+    }
+    for (Worker *worker: workers_) {
+        worker->thread_.join();
+    }
+}
+
+bool ContestRouter::route(const char *line) {
+    while (*line == ' ' || *line == '\t') {
+        ++line;
+    }
+    std::string id;
+    if (*line == '@') {
+        const char *id_end = line;
+        while (*id_end != '\0' && *id_end != ' ' && *id_end != '\t' && *id_end != '\r') {
+            ++id_end;
+        }
+        id.assign(line, id_end);
+        line = id_end;
+    }
+    auto it = contests_.find(id);
+    if (it == contests_.end()) {
+        // a new contest goes to the workers in turn
+        Worker *worker = workers_[contests_.size() % workers_.size()];
+        auto *contest = new Contest(id.empty() ? id : id + ' ', worker);
+        worker->contests_.push_back(contest);
+        it = contests_.emplace(id, contest).first;
+    }
+    Contest *contest = it->second;
+    Task &task = contest->worker_->tasks_.beginPush();
+    if (!ICPCManagementSystem::parseCommand(line, task.command_)) {
+        return true;
+    }
+    task.contest_ = contest;
+    bool end = id.empty() && task.command_.type_ == ICPCManagementSystem::Command::kEnd;
+    contest->worker_->tasks_.commitPush();
+    return !end;
+}
+
+void ContestRouter::runWorker(Worker *worker, int core) {
+    if (core >= 0) {
+        cpu_set_t core_set;
+        CPU_ZERO(&core_set);
+        CPU_SET(core, &core_set);
+        pthread_setaffinity_np(pthread_self(), sizeof(core_set), &core_set);
+    }
+    OutputBuffer &output = worker->output_;
+    while (true) {
+        if (worker->tasks_.empty() && !output.empty()) {
+            // write the output before waiting, so the replies are not held back by an idle input
+            writeOutput(output);
+        }
+        const Task &task = worker->tasks_.beginPop();
+        Contest *contest = task.contest_;
+        if (contest == nullptr) {
+            worker->tasks_.commitPop();
+            break;
+        }
+        if (!contest->ended_) {
+            contest->ended_ = !contest->system_.execute(task.command_);
+        }
+        worker->tasks_.commitPop();
+        // tag each line of the output of the command
+        const char *line = contest->output_.data(), *end = line + contest->output_.size(), *line_end;
+        while (line < end) {
+            line_end = static_cast<const char *>(memchr(line, '\n', end - line));
+            line_end = line_end == nullptr ? end : line_end + 1;
+            output.putString(contest->tag_);
+            output.putString(line, line_end - line);
+            line = line_end;
+        }
+        contest->output_.consume(contest->output_.size());
+        if (output.size() >= kOutputFlushSize) {
+            writeOutput(output);
+        }
+    }
+    writeOutput(output);
+}
+
+void ContestRouter::writeOutput(OutputBuffer &output) {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    size_t written = 0;
+    while (written < output.size()) {
+        ssize_t ret = write(output_fd_, output.data() + written, output.size() - written);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        written += ret;
+    }
+    output.consume(output.size());
+}
@@ -0,0 +1,122 @@
+#ifndef ACM_ICPC_MANAGEMENT_CONTEST_ROUTER_H
+#define ACM_ICPC_MANAGEMENT_CONTEST_ROUTER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <thread>
+
+#include "icpc_management_system.h"
+#include "output_buffer.h"
+#include "spsc_ring.h"
+
+/**
+ * @brief The class of contest router
+ * @details The class of contest router, which hosts many independent contests in one process.
+ * Each command line may be tagged with a contest id as "@[contest_id] [command]", and is routed to the engine of that contest, which is created on first use. The lines without a tag belong to the default contest.
+ * The engines are sharded over the worker threads, each pinned to a core, and a worker owns its engines and their output, so the engines share nothing but the input and the output streams.
+ * The output lines of a tagged contest are prefixed with its tag. The output of a contest is in order, and the outputs of different contests are interleaved in whole lines.
+ * END of a tagged contest ends that contest only, and END of the default contest ends the input.
+ */
+class ContestRouter {
+public:
+    /**
+     * @brief Construct a new ContestRouter object
+     * @param input_fd the file descriptor to read the commands from
+     * @param output_fd the file descriptor to write the output to
+     * @param workers the number of worker threads, at least 1
+     */
+    ContestRouter(int input_fd, int output_fd, int workers);
+
+    ContestRouter(const ContestRouter &) = delete;
+
+    ContestRouter &operator=(const ContestRouter &) = delete;
+
+    ~ContestRouter();
+
+    /**
+     * @brief Run the router until END of the default contest or the end of the input
+     * @details The input is read and routed on the calling thread, and the engines run on the worker threads
+     */
+    void run();
+
+private:
+    static const size_t kTaskRingSize = 1 << 12; // the capacity of the ring of a worker
+    static const size_t kOutputFlushSize = 1 << 16; // the size of the output of a worker worth a write
+
+    /**
+     * @brief The struct of contest
+     * @details The struct of contest, only touched by its worker after it is created
+     *
+     * @param tag_ The prefix of the output lines, "@[contest_id] ", empty for the default contest
+     * @param worker_ The worker owning the contest
+     * @param output_ The output of the last command, before it is tagged
+     * @param system_ The engine of the contest
+     * @param ended_ Whether the contest has ended
+     */
+    struct Worker;
+
+    struct Contest {
+        Contest(std::string tag, Worker *worker) : tag_(std::move(tag)), worker_(worker), system_(&output_),
+                                                   ended_(false) {}
+
+        std::string tag_;
+        Worker *worker_;
+        OutputBuffer output_;
+        ICPCManagementSystem system_;
+        bool ended_;
+    };
+
+    /**
+     * @brief The struct of task
+     * @details The struct of a command routed to a worker. A task with a nullptr contest stops the worker.
+     */
+    struct Task {
+        Contest *contest_ = nullptr;
+        ICPCManagementSystem::Command command_;
+    };
+
+    /**
+     * @brief The struct of worker
+     *
+     * @param tasks_ The ring of the tasks from the router
+     * @param output_ The tagged output of the contests of the worker, waiting to be written
+     * @param contests_ The contests owned by the worker
+     * @param thread_ The thread of the worker
+     */
+    struct Worker {
+        Worker() : tasks_(kTaskRingSize) {}
+
+        SpscRing<Task> tasks_;
+        OutputBuffer output_;
+        std::vector<Contest *> contests_;
+        std::thread thread_;
+    };
+
+    int input_fd_; // the file descriptor to read the commands from
+    int output_fd_; // the file descriptor to write the output to
+    std::vector<Worker *> workers_; // the workers
+    std::unordered_map<std::string, Contest *> contests_; // the contests by id, only touched by the router
+    std::mutex output_mutex_; // the lock of the output stream, held while a worker writes a chunk of whole lines
+
+    /**
+     * @brief Route a command line to the worker of its contest, creating the contest on first use
+     * @return false if the line is END of the default contest, true otherwise
+     */
+    bool route(const char *line);
+
+    /**
+     * @brief Run a worker until it is stopped
+     * @param worker the worker
+     * @param core the core to pin the worker to, -1 for no pinning
+     */
+    void runWorker(Worker *worker, int core);
+
+    /**
+     * @brief Write the output of a worker to the output stream
+     */
+    void writeOutput(OutputBuffer &output);
+};
+
+#endif //ACM_ICPC_MANAGEMENT_CONTEST_ROUTER_H
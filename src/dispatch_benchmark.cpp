@@ -0,0 +1,131 @@
+//
+// Benchmark of the command dispatcher.
+//
+// It parses a corpus of command lines with ICPCManagementSystem::parseCommand, without executing them, and reports
+// the time per line of each command and of a mix weighted like a contest log.
+//
+// usage: ICPC_dispatch_benchmark [--lines N] [--rounds R]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include "icpc_management_system.h"
+
+/**
+ * @brief The struct of a kind of command lines in the corpus
+ *
+ * @param name_ The name of the kind
+ * @param weight_ The weight of the kind in the mix
+ * @param lines_ The command lines
+ */
+struct Corpus {
+    const char *name_;
+    int weight_;
+    std::vector<std::string> lines_;
+};
+
+static std::string teamName(int team_id) {
+    char name[16];
+    snprintf(name, sizeof(name), "team%05d", team_id);
+    return name;
+}
+
+/**
+ * @brief Generate the command lines of each kind
+ */
+static std::vector<Corpus> generateCorpus(int lines) {
+    static const char *const kStatus[] = {"Accepted", "Wrong_Answer", "Runtime_Error", "Time_Limit_Exceed"};
+    std::mt19937 random(1);
+    std::vector<Corpus> corpus = {{"SUBMIT", 80, {}},
+                                  {"QUERY_RANKING", 8, {}},
+                                  {"QUERY_SUBMISSION", 8, {}},
+                                  {"FLUSH", 2, {}},
+                                  {"QUERY_TOP", 1, {}},
+                                  {"ADDTEAM", 1, {}}};
+    char line[128];
+    for (int i = 0; i < lines; ++i) {
+        std::string team = teamName(static_cast<int>(random() % 10000));
+        char problem = static_cast<char>('A' + random() % 26);
+        snprintf(line, sizeof(line), "SUBMIT %c BY %s WITH %s AT %d", problem, team.c_str(), kStatus[random() % 4],
+                 i / 100 + 1);
+        corpus[0].lines_.emplace_back(line);
+        corpus[1].lines_.push_back("QUERY_RANKING " + team);
+        snprintf(line, sizeof(line), "QUERY_SUBMISSION %s WHERE PROBLEM=%s AND STATUS=%s", team.c_str(),
+                 random() % 2 ? "ALL" : std::string(1, problem).c_str(), random() % 2 ? "ALL" : kStatus[random() % 4]);
+        corpus[2].lines_.emplace_back(line);
+        corpus[3].lines_.emplace_back("FLUSH");
+        corpus[4].lines_.push_back("QUERY_TOP " + std::to_string(random() % 100 + 1));
+        corpus[5].lines_.push_back("ADDTEAM " + team);
+    }
+    return corpus;
+}
+
+/**
+ * @brief Parse the lines for several rounds
+ * @return The time per line in nanoseconds
+ */
+static double parseLines(const std::vector<const char *> &lines, int rounds, long long &checksum) {
+    ICPCManagementSystem::Command command;
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const char *line: lines) {
+            ICPCManagementSystem::parseCommand(line, command);
+            checksum += command.type_ + command.problem_ + command.result_ + command.time_ + command.count_;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return seconds * 1e9 / (static_cast<double>(lines.size()) * rounds);
+}
+
+int main(int argc, char *argv[]) {
+    int lines = 100000, rounds = 20;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--lines") == 0 && i + 1 < argc) {
+            lines = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else {
+            lines = 0;
+            break;
+        }
+    }
+    if (lines <= 0 || rounds <= 0) {
+        fprintf(stderr, "usage: %s [--lines N] [--rounds R]\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Corpus> corpus = generateCorpus(lines);
+    long long checksum = 0;
+    std::vector<const char *> mix;
+    std::mt19937 random(2);
+    for (auto &kind: corpus) {
+        std::vector<const char *> kind_lines;
+        for (auto &line: kind.lines_) {
+            kind_lines.push_back(line.c_str());
+        }
+        printf("%-18s %6.1f ns/line\n", kind.name_, parseLines(kind_lines, rounds, checksum));
+    }
+    // the mix picks the kinds by weight, so the dispatcher sees an unpredictable sequence of commands
+    int total_weight = 0;
+    for (auto &kind: corpus) {
+        total_weight += kind.weight_;
+    }
+    for (int i = 0; i < lines; ++i) {
+        int pick = static_cast<int>(random() % total_weight);
+        size_t kind = 0;
+        while (pick >= corpus[kind].weight_) {
+            pick -= corpus[kind].weight_;
+            ++kind;
+        }
+        mix.push_back(corpus[kind].lines_[i].c_str());
+    }
+    printf("%-18s %6.1f ns/line\n", "mix", parseLines(mix, rounds, checksum));
+    printf("checksum %lld\n", checksum);
+    return 0;
+}
@@ -0,0 +1,1514 @@
+#include "icpc_management_system.h"
+
+#include <queue>
+#include <iterator>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+
+void ICPCManagementSystem::TeamNameIndex::reserve(int count) {
+    size_t size = 1;
+    while (size < 2 * static_cast<size_t>(count)) {
+        size <<= 1;
+    }
+    delete[] slots_;
+    mask_ = size - 1;
+    slots_ = new std::atomic<Team *>[size]();
+}
+
+void ICPCManagementSystem::TeamNameIndex::insert(Team *team) {
+    size_t slot = std::hash<std::string_view>()(team->name_.view()) & mask_;
+    while (true) {
+        Team *expected = nullptr;
+        if (slots_[slot].compare_exchange_strong(expected, team, std::memory_order_relaxed)) {
+            return;
+        }
+        slot = (slot + 1) & mask_;
+    }
+}
+
+ICPCManagementSystem::Team *ICPCManagementSystem::TeamNameIndex::find(std::string_view name) const {
+    if (slots_ == nullptr) {
+        return nullptr;
+    }
+    size_t slot = std::hash<std::string_view>()(name) & mask_;
+    while (Team *team = slots_[slot].load(std::memory_order_relaxed)) {
+        if (team->name_ == name) {
+            return team;
+        }
+        slot = (slot + 1) & mask_;
+    }
+    return nullptr;
+}
+
+template<typename Function>
+int ICPCManagementSystem::SubmissionList::visit(int problem_id, int result, int limit, Function visit) const {
+    if (limit <= 0) {
+        limit = static_cast<int>(times_.size());
+    }
+    int count = 0;
+    if (problem_id == problems_ && result == kStatusCount) {
+        // all the submissions
+        for (int index = static_cast<int>(times_.size()) - 1; index >= 0 && count < limit; --index, ++count) {
+            visit(index);
+        }
+        return count;
+    }
+    if (problem_id != problems_ && result != kStatusCount) {
+        // a single list
+        for (int index = heads_[problem_id * kStatusCount + result]; index >= 0 && count < limit;
+             index = getPrevious(index), ++count) {
+            visit(index);
+        }
+        return count;
+    }
+    // merge the lists of all the problems or all the results by a heap of their newest submissions
+    int candidates[kMaxProblemCount * kStatusCount], size = 0;
+    int problem_begin = problem_id == problems_ ? 0 : problem_id;
+    int problem_end = problem_id == problems_ ? problems_ : problem_id + 1;
+    int result_begin = result == kStatusCount ? 0 : result;
+    int result_end = result == kStatusCount ? kStatusCount : result + 1;
+    for (int i = problem_begin; i < problem_end; ++i) {
+        for (int j = result_begin; j < result_end; ++j) {
+            if (heads_[i * kStatusCount + j] >= 0) {
+                candidates[size++] = heads_[i * kStatusCount + j];
+            }
+        }
+    }
+    std::make_heap(candidates, candidates + size);
+    while (size > 0 && count < limit) {
+        std::pop_heap(candidates, candidates + size);
+        int index = candidates[--size];
+        visit(index);
+        ++count;
+        int previous = getPrevious(index);
+        if (previous >= 0) {
+            candidates[size++] = previous;
+            std::push_heap(candidates, candidates + size);
+        }
+    }
+    return count;
+}
+
+void ICPCManagementSystem::SubmissionHistory::reset(int teams, int problems) {
+    teams_ = teams;
+    problems_ = problems;
+    interval_ = std::max(static_cast<size_t>(teams) * problems, static_cast<size_t>(kMinCheckpointInterval));
+    time_column_.clear();
+    team_column_.clear();
+    problem_column_.clear();
+    result_column_.clear();
+    checkpoints_.clear();
+    current_.assign(static_cast<size_t>(teams) * problems, Cell{0, 0});
+}
+
+void ICPCManagementSystem::SubmissionHistory::append(int team_id, int problem_id, int result, int time) {
+    time_column_.push_back(time);
+    team_column_.push_back(team_id);
+    problem_column_.push_back(static_cast<unsigned char>(problem_id));
+    result_column_.push_back(static_cast<unsigned char>(result));
+    apply(time_column_.size() - 1, current_.data());
+    if (time_column_.size() % interval_ == 0) {
+        checkpoints_.push_back(current_);
+    }
+}
+
+void ICPCManagementSystem::SubmissionHistory::replay(int time, Cell *cells) const {
+    // the number of the submissions no later than the time
+    size_t end = upperBound(time);
+    size_t checkpoint = end / interval_, begin = checkpoint * interval_;
+    if (checkpoint == 0) {
+        std::fill(cells, cells + current_.size(), Cell{0, 0});
+    } else {
+        std::copy(checkpoints_[checkpoint - 1].begin(), checkpoints_[checkpoint - 1].end(), cells);
+    }
+    for (size_t i = begin; i < end; ++i) {
+        apply(i, cells);
+    }
+}
+
+void ICPCManagementSystem::SubmissionHistory::countByProblem(size_t begin, size_t end,
+                                                             long long counts[kMaxProblemCount][kStatusCount]) const {
+    // count the combined keys into 4 tables in turn, so that the consecutive increments do not depend on each other
+    static const int kKeyCount = kMaxProblemCount * kStatusCount;
+    static const int kTableCount = 4;
+    int tables[kTableCount][kKeyCount] = {};
+    const unsigned char *problems = problem_column_.data(), *results = result_column_.data();
+    while (begin < end) {
+        // flush the tables before an int counter may overflow
+        size_t block_end = std::min(end, begin + (static_cast<size_t>(1) << 30));
+        size_t i = begin;
+        for (; i + kTableCount <= block_end; i += kTableCount) {
+            for (int j = 0; j < kTableCount; ++j) {
+                ++tables[j][problems[i + j] * kStatusCount + results[i + j]];
+            }
+        }
+        for (; i < block_end; ++i) {
+            ++tables[0][problems[i] * kStatusCount + results[i]];
+        }
+        for (int key = 0; key < kKeyCount; ++key) {
+            for (auto &table: tables) {
+                counts[key / kStatusCount][key % kStatusCount] += table[key];
+                table[key] = 0;
+            }
+        }
+        begin = block_end;
+    }
+}
+
+void ICPCManagementSystem::SubmissionHistory::findFirstAccepted(long long first[kMaxProblemCount]) const {
+    std::fill(first, first + kMaxProblemCount, -1);
+    // the scan stops as soon as every problem has been accepted
+    int remaining = problems_;
+    const unsigned char *problems = problem_column_.data(), *results = result_column_.data();
+    for (size_t i = 0, size = time_column_.size(); i < size && remaining > 0; ++i) {
+        if (results[i] == 0 && first[problems[i]] < 0) {
+            first[problems[i]] = static_cast<long long>(i);
+            --remaining;
+        }
+    }
+}
+
+void ICPCManagementSystem::SubmissionHistory::countWrongAnswers(size_t begin, size_t end, int &total, int &wrong) const {
+    // compare 16 results at a time, and count the matches in 16 byte lanes, which are summed before they may overflow
+    typedef unsigned char ByteVector __attribute__((vector_size(16)));
+    static const size_t kLanes = sizeof(ByteVector);
+    static const int kMaxRounds = 255;
+    const unsigned char *results = result_column_.data();
+    const ByteVector wrong_answer = ByteVector{} + 1;
+    int count = 0;
+    size_t i = begin;
+    while (i + kLanes <= end) {
+        ByteVector lanes = {};
+        for (int round = 0; round < kMaxRounds && i + kLanes <= end; ++round, i += kLanes) {
+            ByteVector block;
+            memcpy(&block, results + i, kLanes);
+            lanes -= reinterpret_cast<ByteVector>(block == wrong_answer);
+        }
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            count += lanes[lane];
+        }
+    }
+    for (; i < end; ++i) {
+        count += results[i] == 1;
+    }
+    total = static_cast<int>(end - begin);
+    wrong = count;
+}
+
+class ICPCManagementSystem::ScrollPlanner {
+public:
+    /**
+     * @brief The struct of a change printed by scroll
+     *
+     * @param team_ The position of the team in teams_
+     * @param replaced_team_ The position of the team it passes in teams_
+     * @param accepted_count_ The number of accepted problems of the team after the change
+     * @param penalty_ The penalty of the team after the change
+     */
+    struct Change {
+        int team_;
+        int replaced_team_;
+        int accepted_count_;
+        int penalty_;
+    };
+
+    ScrollPlanner() : model_(nullptr), incoming_(nullptr), version_(0), planned_version_(0), active_(false),
+                      stopping_(false) {
+        thread_ = std::thread(&ScrollPlanner::work, this);
+    }
+
+    ScrollPlanner(const ScrollPlanner &) = delete;
+
+    ScrollPlanner &operator=(const ScrollPlanner &) = delete;
+
+    ~ScrollPlanner() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            version_.fetch_add(1);
+        }
+        wake_.notify_one();
+        thread_.join();
+        delete model_;
+        delete incoming_;
+    }
+
+    /**
+     * @brief Copy the ranking records, the frozen problems and the submissions waiting for flushing of the system, and plan the scroll from them. Called when freezing, and when flushing while frozen.
+     */
+    void rebase(const ICPCManagementSystem &system);
+
+    /**
+     * @brief Update the copy of a frozen problem of a team after a submission, and plan again
+     */
+    void update(int team, int problem_id, const Team::Problem &problem);
+
+    /**
+     * @brief Wait for the changes planned from the latest copy, and stop planning until the next rebase
+     * @param changes the changes, in the order of printing
+     * @return false if nothing has been planned since the scoreboard was frozen
+     */
+    bool take(std::vector<Change> &changes);
+
+private:
+    /**
+     * @brief The struct of a submission waiting for flushing, with the position of the team in teams_, since the background thread never reads the teams
+     */
+    struct Pending {
+        int team_;
+        int problem_;
+        int result_;
+        int time_;
+    };
+
+    /**
+     * @brief The struct of the private copy of the system
+     *
+     * @param rankings_ The ranking records of the teams, in the order of teams_, so the tie is broken by the address as in the system
+     * @param frozen_problems_ The bitmask of frozen problems of each team
+     * @param problems_ The problems of the teams waiting for flushing or frozen, by the position of the team * kMaxProblemCount + the problem id
+     * @param submissions_ The submissions waiting for flushing
+     */
+    struct Model {
+        std::vector<TeamRanking> rankings_;
+        std::vector<int> frozen_problems_;
+        std::unordered_map<int, Team::Problem> problems_;
+        std::vector<Pending> submissions_;
+    };
+
+    /**
+     * @brief The struct of an update of a frozen problem
+     */
+    struct Update {
+        int team_;
+        int problem_;
+        Team::Problem data_;
+    };
+
+    static const int kCancelInterval = 1 << 10; // the number of teams or changes between two checks for a newer version
+
+    std::thread thread_; // the background thread
+    std::mutex mutex_; // the lock of the fields below, except model_ which only the background thread touches
+    std::condition_variable wake_; // the background thread waits on it for a new version
+    std::condition_variable planned_; // scroll waits on it for the changes of the latest version
+    Model *model_; // the copy planned from, owned by the background thread
+    Model *incoming_; // the copy of the latest rebase, not taken by the background thread yet
+    std::vector<Update> updates_; // the updates since the copy was taken, not applied by the background thread yet
+    std::vector<Change> changes_; // the changes of planned_version_
+    std::atomic<unsigned long long> version_; // increased by each rebase and update, and when the scoreboard is scrolled
+    unsigned long long planned_version_; // the version of changes_
+    bool active_; // whether the scoreboard is frozen and a copy has been taken
+    bool stopping_; // whether the planner is being destroyed
+
+    /**
+     * @brief The loop of the background thread, which plans the latest version whenever it changes
+     */
+    void work();
+
+    /**
+     * @brief Run flush and scroll on a scratch copy of the model, collecting the changes
+     * @return false if a newer version comes before it finishes
+     */
+    bool plan(const Model &model, unsigned long long version, std::vector<Change> &changes) const;
+};
+
+void ICPCManagementSystem::ScrollPlanner::rebase(const ICPCManagementSystem &system) {
+    auto *model = new Model;
+    model->rankings_.assign(system.team_rankings_, system.team_rankings_ + system.team_count_);
+    model->frozen_problems_.resize(system.team_count_);
+    for (int i = 0; i < system.team_count_; ++i) {
+        const Team &team = system.teams_[i];
+        model->frozen_problems_[i] = team.frozen_problems_;
+        for (int mask = team.frozen_problems_; mask; mask &= mask - 1) {
+            int problem_id = __builtin_ctz(mask);
+            model->problems_[i * kMaxProblemCount + problem_id] = team.problems_[problem_id];
+        }
+    }
+    for (const Submission &submission: system.submissions_) {
+        int team = static_cast<int>(submission.team_ - system.teams_);
+        model->problems_[team * kMaxProblemCount + submission.problem_] =
+                submission.team_->problems_[submission.problem_];
+        model->submissions_.push_back({team, submission.problem_, submission.result_, submission.time_});
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        delete incoming_;
+        incoming_ = model;
+        updates_.clear();
+        active_ = true;
+        version_.fetch_add(1);
+    }
+    wake_.notify_one();
+}
+
+void ICPCManagementSystem::ScrollPlanner::update(int team, int problem_id, const Team::Problem &problem) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_) {
+            return;
+        }
+        updates_.push_back({team, problem_id, problem});
+        version_.fetch_add(1);
+    }
+    wake_.notify_one();
+}
+
+bool ICPCManagementSystem::ScrollPlanner::take(std::vector<Change> &changes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!active_) {
+        return false;
+    }
+    planned_.wait(lock, [this] {
+        return planned_version_ == version_.load();
+    });
+    changes.swap(changes_);
+    changes_.clear();
+    active_ = false;
+    version_.fetch_add(1);
+    return true;
+}
+
+void ICPCManagementSystem::ScrollPlanner::work() {
+    std::vector<Change> changes;
+    std::vector<Update> updates;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] {
+            return stopping_ || (active_ && planned_version_ != version_.load());
+        });
+        if (stopping_) {
+            return;
+        }
+        unsigned long long version = version_.load();
+        if (incoming_ != nullptr) {
+            delete model_;
+            model_ = incoming_;
+            incoming_ = nullptr;
+        }
+        updates.swap(updates_);
+        lock.unlock();
+        for (const Update &update: updates) {
+            model_->frozen_problems_[update.team_] |= 1 << update.problem_;
+            model_->problems_[update.team_ * kMaxProblemCount + update.problem_] = update.data_;
+        }
+        updates.clear();
+        changes.clear();
+        bool planned = plan(*model_, version, changes);
+        lock.lock();
+        if (planned && version == version_.load()) {
+            changes_.swap(changes);
+            planned_version_ = version;
+            planned_.notify_all();
+        }
+    }
+}
+
+bool ICPCManagementSystem::ScrollPlanner::plan(const Model &model, unsigned long long version,
+                                               std::vector<Change> &changes) const {
+    std::vector<TeamRanking> rankings(model.rankings_);
+    std::vector<int> frozen_problems(model.frozen_problems_);
+    std::unordered_map<int, Team::Problem> problems(model.problems_);
+    auto add_accepted_time = [](TeamRanking &ranking, int time) {
+        // the accepted times are kept in descending order, like Team::setAcceptTime
+        int i = ranking.accepted_count_++;
+        for (; i > 0 && ranking.accepted_time_[i - 1] < time; --i) {
+            ranking.accepted_time_[i] = ranking.accepted_time_[i - 1];
+        }
+        ranking.accepted_time_[i] = time;
+    };
+    // the flush before scrolling
+    for (const Pending &submission: model.submissions_) {
+        int team = submission.team_;
+        Team::Problem &problem = problems[team * kMaxProblemCount + submission.problem_];
+        if (problem.accepted()) {
+            continue;
+        }
+        if (submission.result_ == 0) {
+            problem.accepted_time_ = submission.time_;
+            rankings[team].penalty_ += problem.getPenalty();
+            add_accepted_time(rankings[team], submission.time_);
+        } else {
+            ++problem.unaccepted_submissions_;
+        }
+    }
+    // the ranking after the flush, appended in order so the leaves are filled
+    std::vector<TeamRanking *> order(rankings.size());
+    for (size_t i = 0; i < rankings.size(); ++i) {
+        order[i] = &rankings[i];
+    }
+    std::sort(order.begin(), order.end(), compareTeam());
+    if (version_.load() != version) {
+        return false;
+    }
+    auto *ranking_set = new BucketedRanking<TeamRanking *, compareTeam, kMaxProblemCount + 1>();
+    std::priority_queue<TeamRanking *, std::vector<TeamRanking *>, compareTeam> teams_with_frozen_problems;
+    for (TeamRanking *ranking: order) {
+        ranking_set->insert(ranking);
+        if (frozen_problems[ranking - rankings.data()]) {
+            teams_with_frozen_problems.push(ranking);
+        }
+    }
+    // the same steps as scroll
+    for (int step = 1; !teams_with_frozen_problems.empty(); ++step) {
+        if (step % kCancelInterval == 0 && version_.load() != version) {
+            delete ranking_set;
+            return false;
+        }
+        TeamRanking *ranking = teams_with_frozen_problems.top();
+        teams_with_frozen_problems.pop();
+        int team = static_cast<int>(ranking - rankings.data());
+        int problem_id = __builtin_ctz(frozen_problems[team]);
+        Team::Problem &problem = problems[team * kMaxProblemCount + problem_id];
+        if (problem.accepted_time_after_frozen_) {
+            ranking_set->erase(ranking);
+            auto runner_up_before_unfreezing = ranking_set->upperBound(ranking);
+            problem.unfreeze();
+            ranking->penalty_ += problem.getPenalty();
+            add_accepted_time(*ranking, problem.accepted_time_);
+            frozen_problems[team] ^= 1 << problem_id;
+            auto runner_up_after_unfreezing = ranking_set->upperBound(ranking);
+            if (runner_up_before_unfreezing != runner_up_after_unfreezing) {
+                changes.push_back({team, static_cast<int>(*runner_up_after_unfreezing - rankings.data()),
+                                   ranking->accepted_count_, ranking->penalty_});
+            }
+            ranking_set->insert(ranking);
+        } else {
+            problem.unfreeze();
+            frozen_problems[team] ^= 1 << problem_id;
+        }
+        if (frozen_problems[team]) {
+            teams_with_frozen_problems.push(ranking);
+        }
+    }
+    delete ranking_set;
+    return true;
+}
+
+ICPCManagementSystem::~ICPCManagementSystem() {
+    delete[] rankings_array_;
+    delete[] team_rankings_;
+    for (int i = 0; i < team_count_; ++i) {
+        teams_[i].~Team();
+    }
+    ::operator delete(teams_);
+    ::operator delete(team_arena_);
+    delete snapshot_.load();
+    for (auto &retired: retired_snapshots_) {
+        delete retired.first;
+    }
+    delete thread_pool_;
+    delete scroll_planner_;
+}
+
+inline bool ICPCManagementSystem::compareTeam::operator()(const ICPCManagementSystem::TeamRanking *a,
+                                                          const ICPCManagementSystem::TeamRanking *b) const {
+    if (a->accepted_count_ != b->accepted_count_) {
+        return a->accepted_count_ > b->accepted_count_;
+    }
+    if (a->penalty_ != b->penalty_) {
+        return a->penalty_ < b->penalty_;
+    }
+    const int accepted_problem_count = a->accepted_count_;
+    for (int i = 0; i < accepted_problem_count; ++i) {
+        if (a->accepted_time_[i] != b->accepted_time_[i]) {
+            return a->accepted_time_[i] < b->accepted_time_[i];
+        }
+    }
+    return a < b;
+}
+
+inline bool ICPCManagementSystem::compareTeam::operator()(const ICPCManagementSystem::Team *a,
+                                                          const ICPCManagementSystem::Team *b) const {
+    return (*this)(a->ranking_, b->ranking_);
+}
+
+inline unsigned long long ICPCManagementSystem::compareTeam::getKey(const ICPCManagementSystem::TeamRanking *ranking) {
+    return static_cast<unsigned long long>(kMaxProblemCount - ranking->accepted_count_) << 32 |
+           static_cast<unsigned int>(ranking->penalty_);
+}
+
+bool ICPCManagementSystem::addTeam(const std::string &team_name) {
+    if (contest_started_) {
+        putMessage(*sink_, Result::kAddFailedStarted);
+        return false;
+    }
+    if (team_name.size() >= kMaxStringLength) {
+        // the name is truncated like a token of a command line, to fit in the name slot
+        return addTeam(team_name.substr(0, kMaxStringLength - 1));
+    }
+    if (names_list_.find(team_name) != names_list_.end()) {
+        putMessage(*sink_, Result::kAddFailedDuplicated);
+        return false;
+    }
+    names_list_.insert(team_name);
+    putMessage(*sink_, Result::kAddSuccessfully);
+    return true;
+}
+
+bool ICPCManagementSystem::startContest(int duration, int problems) {
+    if (contest_started_) {
+        putMessage(*sink_, Result::kStartFailed);
+        return false;
+    }
+    problems_ = problems;
+    const int team_count = static_cast<int>(names_list_.size());
+    std::vector<const std::string *> names;
+    names.reserve(team_count);
+    for (const auto &name: names_list_) {
+        names.push_back(&name);
+    }
+    teams_ = static_cast<Team *>(::operator new(sizeof(Team) * team_count));
+    team_arena_ = ::operator new(Team::getArenaSize(team_count, problems));
+    rankings_array_ = new Team *[team_count];
+    team_rankings_ = new TeamRanking[team_count];
+    name_index_.reserve(team_count);
+    parallelFor(team_count, [this, &names, problems, team_count](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            Team *team = new(teams_ + i) Team();
+            team->initialize(*names[i], problems, i + 1, team_arena_, team_count, i, team_rankings_ + i);
+            rankings_array_[i] = team;
+            name_index_.insert(team);
+        }
+    });
+    team_count_ = team_count;
+    history_.reset(team_count, problems);
+    // the teams are already sorted by name with no submission, so the trees are built bottom-up instead of inserting one by one
+    rankings_.build(team_count_, [this](size_t index) {
+        return team_rankings_ + index;
+    });
+    contest_started_ = true;
+    publishSnapshot();
+    publishDelta();
+    putMessage(*sink_, Result::kStartSuccessfully);
+    return true;
+}
+
+void ICPCManagementSystem::submitSolution(const std::string &team_name, const std::string &problem_string,
+                                          const std::string &result_string,
+                                          int time) {
+    submitSolution(team_name, getProblemID(problem_string), getResultID(result_string), time);
+}
+
+void ICPCManagementSystem::submitBatch(const SubmitRecord *records, size_t count) {
+    batch_teams_.clear();
+    batch_next_.resize(count);
+    Team *team = nullptr;
+    std::string_view team_name;
+    for (size_t i = 0; i < count; ++i) {
+        const SubmitRecord &record = records[i];
+        // a run of records of the same team shares one lookup
+        if (team == nullptr || record.team_name_ != team_name) {
+            team_name = record.team_name_;
+            team = getTeamPointer(team_name);
+        }
+        // chain the record after the previous record of the team
+        if (team->batch_head_ < 0) {
+            team->batch_head_ = static_cast<int>(i);
+            batch_teams_.push_back(team);
+        } else {
+            batch_next_[team->batch_tail_] = static_cast<int>(i);
+        }
+        team->batch_tail_ = static_cast<int>(i);
+        batch_next_[i] = -1;
+        // the submissions waiting for flushing and the history keep the order of the records
+        if (!frozen_) {
+            submissions_.emplace_back(team, record.problem_, record.result_, record.time_);
+        }
+        history_.append(static_cast<int>(team - teams_), record.problem_, record.result_, record.time_);
+    }
+    for (Team *batch_team: batch_teams_) {
+        // update the data of the team under one seqlock section, for the concurrent readers
+        unsigned int sequence = batch_team->sequence_.load(std::memory_order_relaxed);
+        batch_team->sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int i = batch_team->batch_head_; i >= 0; i = batch_next_[i]) {
+            const SubmitRecord &record = records[i];
+            applySubmission(batch_team, record.problem_, record.result_, record.time_);
+            storeLastSubmission(Submission(batch_team, record.problem_, record.result_, record.time_));
+        }
+        batch_team->sequence_.store(sequence + 2, std::memory_order_release);
+        batch_team->batch_head_ = -1;
+    }
+}
+
+void ICPCManagementSystem::flush(bool log) {
+    // a FLUSH while frozen changes the ranking records the scroll starts from, but the flush of scroll is planned
+    bool rebase = log && frozen_ && scroll_planner_ != nullptr && !submissions_.empty();
+    for (auto submission: submissions_) {
+        Team *team = submission.team_;
+        int problem_id = submission.problem_;
+        int result = submission.result_;
+        int time = submission.time_;
+        Team::Problem &problem = team->problems_[problem_id];
+        if (problem.accepted()) {
+            // If the problem has been accepted before flushing, do nothing
+            continue;
+        }
+        team->dirty_ = true;
+        if (result == 0) {
+            // Accepted
+            rankings_.erase(team->ranking_);
+            team->accepted_problems_ |= 1 << problem_id;
+            problem.accepted_time_ = time;
+            team->ranking_->penalty_ += problem.getPenalty();
+            team->setAcceptTime();
+            rankings_.insert(team->ranking_);
+            moved_teams_.push_back(team);
+            problem_stats_[problem_id].addSolver(team, time);
+        } else {
+            // Unaccepted
+            ++problem.unaccepted_submissions_;
+        }
+        ++problem_stats_[problem_id].attempts_;
+    }
+    submissions_.clear();
+    updateRanks();
+    if (rebase) {
+        scroll_planner_->rebase(*this);
+    }
+    if (log) {
+        publishSnapshot();
+        publishDelta();
+        putMessage(*sink_, Result::kFlushSuccessfully);
+    }
+}
+
+void ICPCManagementSystem::updateRanks() {
+    if (moved_teams_.size() * kRankWalkRatio > static_cast<size_t>(team_count_)) {
+        setRanks(1, team_count_);
+        moved_teams_.clear();
+        return;
+    }
+    moved_ranks_.clear();
+    for (Team *team: moved_teams_) {
+        moved_ranks_.emplace_back(static_cast<int>(rankings_.rank(team->ranking_)) + 1, team->rank_);
+    }
+    moved_teams_.clear();
+    std::sort(moved_ranks_.begin(), moved_ranks_.end());
+    for (size_t i = 0; i < moved_ranks_.size();) {
+        int begin = moved_ranks_[i].first, end = moved_ranks_[i].second;
+        for (++i; i < moved_ranks_.size() && moved_ranks_[i].first <= end + 1; ++i) {
+            end = std::max(end, moved_ranks_[i].second);
+        }
+        setRanks(begin, end);
+    }
+}
+
+void ICPCManagementSystem::setRanks(int begin, int end) {
+    // each task finds its first rank in rankings_ and walks its own part, which only reads rankings_
+    parallelFor(end - begin + 1, [this, begin](int first, int last) {
+        auto ranking = rankings_.at(begin - 1 + first);
+        for (int rank = begin + first; rank < begin + last; ++rank, ++ranking) {
+            Team *team = getTeam(*ranking);
+            team->rank_ = rank;
+            rankings_array_[rank - 1] = team;
+        }
+    });
+}
+
+void ICPCManagementSystem::enableScrollPrecompute() {
+    if (scroll_planner_ == nullptr) {
+        scroll_planner_ = new ScrollPlanner();
+    }
+}
+
+void ICPCManagementSystem::precomputeSubmission(const Team *team, int problem_id) {
+    scroll_planner_->update(static_cast<int>(team - teams_), problem_id, team->problems_[problem_id]);
+}
+
+void ICPCManagementSystem::unfreezeTeams() {
+    for (int i = 0; i < team_count_; ++i) {
+        Team *team = teams_ + i;
+        if (!team->frozen_problems_) {
+            continue;
+        }
+        bool accepted = false;
+        for (int mask = team->frozen_problems_; mask; mask &= mask - 1) {
+            accepted |= team->problems_[__builtin_ctz(mask)].accepted_time_after_frozen_ != 0;
+        }
+        if (accepted) {
+            rankings_.erase(team->ranking_);
+        }
+        team->dirty_ = true;
+        while (team->frozen_problems_) {
+            int problem_id = team->getFirstFrozenProblem();
+            Team::Problem &problem = team->problems_[problem_id];
+            ProblemStats &stats = problem_stats_[problem_id];
+            stats.attempts_ +=
+                    problem.unaccepted_submissions_after_frozen_ + (problem.accepted_time_after_frozen_ ? 1 : 0);
+            stats.frozen_attempts_ -= problem.submissions_after_frozen_;
+            bool solved = problem.accepted_time_after_frozen_ != 0;
+            problem.unfreeze();
+            if (solved) {
+                team->accepted_problems_ |= 1 << problem_id;
+                team->ranking_->penalty_ += problem.getPenalty();
+                stats.addSolver(team, problem.accepted_time_);
+            }
+            team->frozen_problems_ ^= 1 << problem_id;
+        }
+        if (accepted) {
+            team->setAcceptTime();
+            rankings_.insert(team->ranking_);
+            moved_teams_.push_back(team);
+        }
+    }
+}
+
+bool ICPCManagementSystem::freeze() {
+    if (frozen_) {
+        putMessage(*sink_, Result::kFreezeFailed);
+        return false;
+    }
+    frozen_ = true;
+    if (scroll_planner_ != nullptr) {
+        scroll_planner_->rebase(*this);
+    }
+    publishSnapshot();
+    publishDelta();
+    putMessage(*sink_, Result::kFreezeSuccessfully);
+    return true;
+}
+
+bool ICPCManagementSystem::scroll() {
+    if (!frozen_) {
+        putMessage(*sink_, Result::kScrollFailed);
+        return false;
+    }
+    putMessage(*sink_, Result::kScrollSuccessfully);
+    flush(false);
+    printRankings();
+    std::vector<ScrollPlanner::Change> changes;
+    if (scroll_planner_ != nullptr && scroll_planner_->take(changes)) {
+        // the changes are already known, and the teams are unfrozen at once
+        Result result;
+        result.type_ = Result::kScrollChange;
+        for (const ScrollPlanner::Change &change: changes) {
+            result.team_ = teams_ + change.team_;
+            result.replaced_team_ = teams_ + change.replaced_team_;
+            result.accepted_count_ = change.accepted_count_;
+            result.penalty_ = change.penalty_;
+            sink_->put(result);
+        }
+        unfreezeTeams();
+    } else {
+        std::priority_queue<Team *, std::vector<Team *>, compareTeam> teams_with_frozen_problems;
+        for (int i = 0; i < team_count_; ++i) {
+            Team *team = rankings_array_[i];
+            if (team->frozen_problems_) {
+                teams_with_frozen_problems.push(team);
+            }
+        }
+        while (!teams_with_frozen_problems.empty()) {
+            Team *team = teams_with_frozen_problems.top();
+            teams_with_frozen_problems.pop();
+            int problem_id = team->getFirstFrozenProblem();
+            Team::Problem &problem = team->problems_[problem_id];
+            // the frozen attempts of the problem are revealed
+            team->dirty_ = true;
+            ProblemStats &stats = problem_stats_[problem_id];
+            stats.attempts_ += problem.unaccepted_submissions_after_frozen_ +
+                               (problem.accepted_time_after_frozen_ ? 1 : 0);
+            stats.frozen_attempts_ -= problem.submissions_after_frozen_;
+            if (problem.accepted_time_after_frozen_) {
+                rankings_.erase(team->ranking_);
+                auto runner_up_before_unfreezing = rankings_.upperBound(team->ranking_);
+                problem.unfreeze();
+                if (problem.accepted()) {
+                    team->accepted_problems_ |= 1 << problem_id;
+                    team->ranking_->penalty_ += problem.getPenalty();
+                    team->setAcceptTime();
+                    stats.addSolver(team, problem.accepted_time_);
+                }
+                team->frozen_problems_ ^= 1 << problem_id;
+                auto runner_up_after_unfreezing = rankings_.upperBound(team->ranking_);
+                if (runner_up_before_unfreezing != runner_up_after_unfreezing) {
+                    Result result;
+                    result.type_ = Result::kScrollChange;
+                    result.team_ = team;
+                    result.replaced_team_ = getTeam(*runner_up_after_unfreezing);
+                    result.accepted_count_ = team->getAcceptedCount();
+                    result.penalty_ = team->getPenalty();
+                    sink_->put(result);
+                }
+                rankings_.insert(team->ranking_);
+                moved_teams_.push_back(team);
+            } else {
+                problem.unfreeze();
+                team->frozen_problems_ ^= 1 << problem_id;
+            }
+            if (team->frozen_problems_) {
+                teams_with_frozen_problems.push(team);
+            }
+        }
+    }
+    flush(false);
+    printRankings();
+    frozen_ = false;
+    publishSnapshot();
+    publishDelta();
+    return true;
+}
+
+bool ICPCManagementSystem::querySubmission(const std::string &team_name, const std::string &problem_string,
+                                           const std::string &result_string) {
+    return querySubmission(team_name, getProblemID(problem_string), getResultID(result_string));
+}
+
+void ICPCManagementSystem::putMessage(ResultSink &sink, int message) {
+    Result result;
+    result.type_ = Result::kMessage;
+    result.message_ = static_cast<unsigned char>(message);
+    sink.put(result);
+}
+
+void ICPCManagementSystem::putRanking(ResultSink &sink, const Team *team, int rank, bool frozen) {
+    Result result;
+    result.type_ = Result::kRanking;
+    result.team_ = team;
+    result.rank_ = rank;
+    result.frozen_ = frozen;
+    sink.put(result);
+}
+
+void ICPCManagementSystem::putSubmission(ResultSink &sink, const Team *team, const Submission &submission) {
+    Result result;
+    result.type_ = Result::kSubmission;
+    result.team_ = team;
+    result.problem_ = submission.exists() ? submission.problem_ : -1;
+    result.result_ = submission.result_;
+    result.time_ = submission.time_;
+    sink.put(result);
+}
+
+inline void ICPCManagementSystem::putTeamName(OutputBuffer &output, const Team *team) {
+    output.putPrefix(team->name_.data_, team->name_.length_);
+}
+
+void ICPCManagementSystem::formatResult(const Result &result, OutputBuffer &output) {
+    switch (result.type_) {
+        case Result::kMessage:
+            output.putLine(Result::kMessageString[result.message_]);
+            break;
+        case Result::kRanking:
+            output.putLine("[Info]Complete query ranking.");
+            if (result.frozen_) {
+                output.putLine(Result::kMessageString[Result::kFrozenWarning]);
+            }
+            putTeamName(output, result.team_);
+            output.putString(" NOW AT RANKING ");
+            output.putInt(result.rank_);
+            output.putChar('\n');
+            break;
+        case Result::kSubmission:
+            output.putLine("[Info]Complete query submission.");
+            if (result.problem_ < 0) {
+                output.putLine("Cannot find any submission.");
+            } else {
+                putTeamName(output, result.team_);
+                output.putChar(' ');
+                output.putChar(getProblemName(result.problem_));
+                output.putChar(' ');
+                output.putString(kStatusString[result.result_]);
+                output.putChar(' ');
+                output.putInt(result.time_);
+                output.putChar('\n');
+            }
+            break;
+        case Result::kScrollChange:
+            putTeamName(output, result.team_);
+            output.putChar(' ');
+            putTeamName(output, result.replaced_team_);
+            output.putChar(' ');
+            output.putInt(result.accepted_count_);
+            output.putChar(' ');
+            output.putInt(result.penalty_);
+            output.putChar('\n');
+            break;
+        case Result::kRow:
+            putTeamName(output, result.team_);
+            output.putChar(' ');
+            output.putInt(result.rank_);
+            output.putChar(' ');
+            output.putInt(result.accepted_count_);
+            output.putChar(' ');
+            output.putInt(result.penalty_);
+            output.putChar(' ');
+            for (int problem_id = 0; problem_id < result.problem_count_; ++problem_id) {
+                putCell(output, result.cells_[problem_id]);
+                output.putChar(' ');
+            }
+            output.putChar('\n');
+            break;
+        case Result::kHistorySubmission:
+            putTeamName(output, result.team_);
+            output.putChar(' ');
+            output.putChar(getProblemName(result.problem_));
+            output.putChar(' ');
+            output.putString(kStatusString[result.result_]);
+            output.putChar(' ');
+            output.putInt(result.time_);
+            output.putChar('\n');
+            break;
+        case Result::kProblemAnalysis:
+            output.putChar(getProblemName(result.problem_));
+            output.putChar(' ');
+            output.putInt(result.accepted_count_);
+            output.putChar(' ');
+            output.putInt(result.total_);
+            if (result.team_ == nullptr) {
+                output.putString(" NONE\n");
+            } else {
+                output.putChar(' ');
+                putTeamName(output, result.team_);
+                output.putChar(' ');
+                output.putInt(result.time_);
+                output.putChar('\n');
+            }
+            break;
+        case Result::kProblemStats:
+            output.putChar(getProblemName(result.problem_));
+            output.putChar(' ');
+            output.putInt(result.accepted_count_);
+            output.putChar(' ');
+            output.putInt(result.total_);
+            output.putChar(' ');
+            output.putInt(result.count_);
+            if (result.team_ == nullptr) {
+                output.putString(" NONE\n");
+            } else {
+                output.putChar(' ');
+                putTeamName(output, result.team_);
+                output.putChar(' ');
+                output.putInt(result.time_);
+                output.putChar('\n');
+            }
+            break;
+        case Result::kBucketAnalysis: {
+            output.putInt(result.time_);
+            output.putChar('-');
+            output.putInt(result.end_);
+            output.putChar(' ');
+            output.putInt(result.total_);
+            output.putChar(' ');
+            output.putInt(result.count_);
+            output.putChar(' ');
+            // the rate rounded to 3 decimal places
+            int permille = result.total_ ? static_cast<int>(
+                    (static_cast<long long>(result.count_) * 1000 + result.total_ / 2) / result.total_) : 0;
+            output.putInt(permille / 1000);
+            output.putChar('.');
+            output.putChar(static_cast<char>('0' + permille / 100 % 10));
+            output.putChar(static_cast<char>('0' + permille / 10 % 10));
+            output.putChar(static_cast<char>('0' + permille % 10));
+            output.putChar('\n');
+            break;
+        }
+        case Result::kHistoryRanking:
+            output.putLine("[Info]Complete query history ranking.");
+            putTeamName(output, result.team_);
+            output.putString(" AT ");
+            output.putInt(result.time_);
+            output.putString(" AT RANKING ");
+            output.putInt(result.rank_);
+            output.putChar('\n');
+            break;
+        case Result::kEnd:
+            break;
+    }
+}
+
+void ICPCManagementSystem::putCell(OutputBuffer &output, unsigned long long cell) {
+    int unaccepted_submissions = static_cast<int>(cell >> 2 & 0x7fffffff);
+    if ((cell & 3) == Team::kCellFrozen) {
+        output.putInt(-unaccepted_submissions);
+        output.putChar('/');
+        output.putInt(static_cast<int>(cell >> 33));
+    } else if ((cell & 3) == Team::kCellAccepted) {
+        output.putChar('+');
+        if (unaccepted_submissions) {
+            output.putInt(unaccepted_submissions);
+        }
+    } else {
+        if (unaccepted_submissions) {
+            output.putInt(-unaccepted_submissions);
+        } else {
+            output.putChar('.');
+        }
+    }
+}
+
+void ICPCManagementSystem::publishDelta() {
+    if (delta_output_ == nullptr) {
+        return;
+    }
+    OutputBuffer &output = *delta_output_;
+    output.putString("{\"publish\":");
+    output.putInt(static_cast<int>(++publish_count_));
+    output.putString(frozen_ ? ",\"frozen\":true,\"teams\":[" : ",\"frozen\":false,\"teams\":[");
+    bool first = true;
+    for (int i = 0; i < team_count_; ++i) {
+        Team *team = rankings_array_[i];
+        bool changed = team->rank_ != team->published_rank_;
+        if (team->dirty_ || changed) {
+            // the digest of a team which has not submitted is unchanged
+            unsigned long long digest = team->getDigest(problems_);
+            changed |= digest != team->published_digest_;
+            team->published_digest_ = digest;
+            team->dirty_ = false;
+        }
+        if (!changed) {
+            continue;
+        }
+        team->published_rank_ = team->rank_;
+        output.putString(first ? "{\"name\":\"" : ",{\"name\":\"");
+        first = false;
+        putTeamName(output, team);
+        output.putString("\",\"rank\":");
+        output.putInt(team->rank_);
+        output.putString(",\"solved\":");
+        output.putInt(team->getAcceptedCount());
+        output.putString(",\"penalty\":");
+        output.putInt(team->getPenalty());
+        output.putString(",\"cells\":[");
+        for (int problem_id = 0; problem_id < problems_; ++problem_id) {
+            output.putString(problem_id ? ",\"" : "\"");
+            putCell(output, team->getCell(problem_id));
+            output.putChar('"');
+        }
+        output.putString("]}");
+    }
+    output.putString("]}\n");
+    output.flush();
+}
+
+void ICPCManagementSystem::publishSnapshot() {
+    if (!concurrent_reads_) {
+        return;
+    }
+    auto *snapshot = new RankingSnapshot{frozen_, std::vector<int>(team_count_)};
+    parallelFor(team_count_, [this, snapshot](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            snapshot->ranks_[i] = teams_[i].rank_;
+        }
+    });
+    RankingSnapshot *retired = snapshot_.exchange(snapshot);
+    if (retired != nullptr) {
+        retired_snapshots_.emplace_back(retired, epoch_.fetch_add(1));
+    }
+    // a reader may still be reading a snapshot retired at an epoch no less than the epoch it observed
+    unsigned long long oldest_epoch = epoch_.load();
+    for (auto &reader: reader_epochs_) {
+        unsigned long long epoch = reader.epoch_.load();
+        if (epoch != 0 && epoch < oldest_epoch) {
+            oldest_epoch = epoch;
+        }
+    }
+    auto it = std::remove_if(retired_snapshots_.begin(), retired_snapshots_.end(),
+                             [oldest_epoch](const std::pair<RankingSnapshot *, unsigned long long> &retired) {
+                                 if (retired.second < oldest_epoch) {
+                                     delete retired.first;
+                                     return true;
+                                 }
+                                 return false;
+                             });
+    retired_snapshots_.erase(it, retired_snapshots_.end());
+}
+
+bool ICPCManagementSystem::executeReadOnlyCommand(const char *line, OutputBuffer &output, int reader_id) {
+    Command command;
+    if (!parseCommand(line, command) ||
+        (command.type_ != Command::kQueryRanking && command.type_ != Command::kQuerySubmission)) {
+        return false;
+    }
+    std::atomic<unsigned long long> &reader_epoch = reader_epochs_[reader_id].epoch_;
+    reader_epoch.store(epoch_.load());
+    RankingSnapshot *snapshot = snapshot_.load();
+    if (snapshot == nullptr) {
+        // the contest has not started, and the team index is not built yet
+        reader_epoch.store(0);
+        return false;
+    }
+    ResultFormatter formatter(&output);
+    Team *team = getTeamPointer(command.team_name_);
+    if (command.type_ == Command::kQueryRanking) {
+        if (team == nullptr) {
+            putMessage(formatter, Result::kQueryRankingFailed);
+        } else {
+            putRanking(formatter, team, snapshot->ranks_[team - teams_], snapshot->frozen_);
+        }
+    } else {
+        if (team == nullptr) {
+            putMessage(formatter, Result::kQuerySubmissionFailed);
+        } else {
+            putSubmission(formatter, team,
+                          team->readSubmission(command.result_, getProblemID(command.problem_)));
+        }
+    }
+    reader_epoch.store(0, std::memory_order_release);
+    return true;
+}
+
+void ICPCManagementSystem::printRankings(bool debug) {
+    putRows(0, team_count_);
+}
+
+int ICPCManagementSystem::queryTop(int k) {
+    int count = std::max(0, std::min(k, team_count_));
+    putMessage(*sink_, Result::kQueryTopSuccessfully);
+    if (frozen_) {
+        putMessage(*sink_, Result::kFrozenWarning);
+    }
+    putRows(0, count);
+    return count;
+}
+
+int ICPCManagementSystem::printRange(int from, int to) {
+    if (from < 1 || to < from) {
+        putMessage(*sink_, Result::kPrintRangeFailed);
+        return -1;
+    }
+    int begin = std::min(from - 1, team_count_), end = std::min(to, team_count_);
+    putMessage(*sink_, Result::kPrintRangeSuccessfully);
+    if (frozen_) {
+        putMessage(*sink_, Result::kFrozenWarning);
+    }
+    putRows(begin, end);
+    return end - begin;
+}
+
+int ICPCManagementSystem::querySubmissionHistory(std::string_view team_name, int problem_id, int result,
+                                                 int limit) {
+    // the same as HISTORY_RANKING, an added team cannot be found before START
+    if (!contest_started_) {
+        putMessage(*sink_, Result::kQueryHistoryFailedNotStarted);
+        return -1;
+    }
+    Team *team = getTeamPointer(team_name);
+    if (team == nullptr) {
+        putMessage(*sink_, Result::kQueryHistoryFailed);
+        return -1;
+    }
+    putMessage(*sink_, Result::kQueryHistorySuccessfully);
+    const SubmissionList &submissions = team->submission_list_;
+    Result record;
+    record.type_ = Result::kHistorySubmission;
+    record.team_ = team;
+    int count = submissions.visit(problem_id, result, limit, [this, &submissions, &record](int index) {
+        record.problem_ = submissions.getProblem(index);
+        record.result_ = submissions.getResult(index);
+        record.time_ = submissions.getTime(index);
+        sink_->put(record);
+    });
+    if (count == 0) {
+        putMessage(*sink_, Result::kNoSubmission);
+    }
+    return count;
+}
+
+void ICPCManagementSystem::queryProblemStats() {
+    putMessage(*sink_, Result::kQueryProblemStatsSuccessfully);
+    if (frozen_) {
+        putMessage(*sink_, Result::kFrozenWarning);
+    }
+    Result result;
+    result.type_ = Result::kProblemStats;
+    for (int problem_id = 0; problem_id < problems_; ++problem_id) {
+        const ProblemStats &stats = problem_stats_[problem_id];
+        result.problem_ = problem_id;
+        result.accepted_count_ = stats.solved_;
+        result.total_ = stats.attempts_;
+        result.count_ = stats.frozen_attempts_;
+        result.team_ = stats.first_solver_;
+        result.time_ = stats.first_time_;
+        sink_->put(result);
+    }
+}
+
+void ICPCManagementSystem::analyzeProblems() {
+    long long counts[kMaxProblemCount][kStatusCount] = {};
+    long long first[kMaxProblemCount];
+    history_.countByProblem(0, history_.size(), counts);
+    history_.findFirstAccepted(first);
+    putMessage(*sink_, Result::kAnalyzeProblemsSuccessfully);
+    Result result;
+    result.type_ = Result::kProblemAnalysis;
+    for (int problem_id = 0; problem_id < problems_; ++problem_id) {
+        long long total = 0;
+        for (long long count: counts[problem_id]) {
+            total += count;
+        }
+        result.problem_ = problem_id;
+        result.accepted_count_ = static_cast<int>(counts[problem_id][0]);
+        result.total_ = static_cast<int>(total);
+        result.team_ = first[problem_id] < 0 ? nullptr : teams_ + history_.getTeam(first[problem_id]);
+        result.time_ = first[problem_id] < 0 ? 0 : history_.getTime(first[problem_id]);
+        sink_->put(result);
+    }
+}
+
+int ICPCManagementSystem::analyzeWrongAnswers(int width) {
+    if (width < 1) {
+        putMessage(*sink_, Result::kAnalyzeWrongAnswersFailed);
+        return -1;
+    }
+    putMessage(*sink_, Result::kAnalyzeWrongAnswersSuccessfully);
+    size_t size = history_.size();
+    if (size == 0) {
+        return 0;
+    }
+    int buckets = history_.getTime(size - 1) / width + 1;
+    Result result;
+    result.type_ = Result::kBucketAnalysis;
+    size_t begin = 0;
+    for (int bucket = 0; bucket < buckets; ++bucket) {
+        // the width may be up to INT_MAX, so the bounds are computed in long long, and the last end is clamped
+        long long bucket_begin = static_cast<long long>(bucket) * width;
+        result.time_ = static_cast<int>(bucket_begin);
+        result.end_ = static_cast<int>(std::min(bucket_begin + width - 1, static_cast<long long>(INT_MAX)));
+        size_t end = history_.upperBound(result.end_);
+        history_.countWrongAnswers(begin, end, result.total_, result.count_);
+        sink_->put(result);
+        begin = end;
+    }
+    return buckets;
+}
+
+int ICPCManagementSystem::queryHistoryRanking(std::string_view team_name, int time) {
+    // the teams are only indexed at START, so an added team cannot be found yet
+    if (!contest_started_) {
+        putMessage(*sink_, Result::kQueryHistoryRankingFailedNotStarted);
+        return -1;
+    }
+    Team *team = getTeamPointer(team_name);
+    if (team == nullptr) {
+        putMessage(*sink_, Result::kQueryHistoryRankingFailed);
+        return -1;
+    }
+    auto *cells = new SubmissionHistory::Cell[static_cast<size_t>(team_count_) * problems_];
+    auto *rows = new HistoryRow[team_count_];
+    buildHistoryRows(time, cells, rows);
+    // the rank is one more than the number of the better teams, no sorting is needed
+    const HistoryRow &row = rows[team - teams_];
+    int rank = 1;
+    for (int i = 0; i < team_count_; ++i) {
+        rank += rows[i] < row;
+    }
+    delete[] cells;
+    delete[] rows;
+    Result result;
+    result.type_ = Result::kHistoryRanking;
+    result.team_ = team;
+    result.rank_ = rank;
+    result.time_ = time;
+    sink_->put(result);
+    return rank;
+}
+
+void ICPCManagementSystem::printHistory(int time) {
+    if (!contest_started_) {
+        putMessage(*sink_, Result::kPrintHistoryFailedNotStarted);
+        return;
+    }
+    auto *cells = new SubmissionHistory::Cell[static_cast<size_t>(team_count_) * problems_];
+    auto *rows = new HistoryRow[team_count_];
+    buildHistoryRows(time, cells, rows);
+    std::sort(rows, rows + team_count_);
+    putMessage(*sink_, Result::kPrintHistorySuccessfully);
+    Result result;
+    result.type_ = Result::kRow;
+    result.problem_count_ = static_cast<unsigned char>(problems_);
+    for (int i = 0; i < team_count_; ++i) {
+        const HistoryRow &row = rows[i];
+        const SubmissionHistory::Cell *team_cells = cells + static_cast<size_t>(row.team_) * problems_;
+        result.team_ = teams_ + row.team_;
+        result.rank_ = i + 1;
+        result.accepted_count_ = row.accepted_count_;
+        result.penalty_ = row.penalty_;
+        for (int problem_id = 0; problem_id < problems_; ++problem_id) {
+            const SubmissionHistory::Cell &cell = team_cells[problem_id];
+            result.cells_[problem_id] = static_cast<unsigned long long>(cell.unaccepted_submissions_) << 2 |
+                                        (cell.accepted_time_ ? Team::kCellAccepted : Team::kCellUntried);
+        }
+        sink_->put(result);
+    }
+    delete[] cells;
+    delete[] rows;
+}
+
+void ICPCManagementSystem::buildHistoryRows(int time, SubmissionHistory::Cell *cells, HistoryRow *rows) const {
+    history_.replay(time, cells);
+    for (int i = 0; i < team_count_; ++i) {
+        const SubmissionHistory::Cell *team_cells = cells + static_cast<size_t>(i) * problems_;
+        HistoryRow &row = rows[i];
+        row.team_ = i;
+        row.accepted_count_ = 0;
+        row.penalty_ = 0;
+        for (int problem_id = 0; problem_id < problems_; ++problem_id) {
+            const SubmissionHistory::Cell &cell = team_cells[problem_id];
+            if (cell.accepted_time_) {
+                row.accepted_time_[row.accepted_count_++] = cell.accepted_time_;
+                row.penalty_ += cell.unaccepted_submissions_ * 20 + cell.accepted_time_;
+            }
+        }
+        std::sort(row.accepted_time_, row.accepted_time_ + row.accepted_count_, std::greater<>());
+    }
+}
+
+void ICPCManagementSystem::putRows(int begin, int end) {
+    if (sink_ != &formatter_ || parallel_render_rows_ <= 0 || end - begin < parallel_render_rows_) {
+        putRows(begin, end, *sink_);
+        return;
+    }
+    if (thread_pool_ == nullptr) {
+        putRows(begin, end, *sink_);
+        return;
+    }
+    renderRows(begin, end, *formatter_.getOutput());
+}
+
+void ICPCManagementSystem::putRows(int begin, int end, ResultSink &sink) const {
+    Result result;
+    result.type_ = Result::kRow;
+    result.problem_count_ = static_cast<unsigned char>(problems_);
+    for (int i = begin; i < end; ++i) {
+        Team *team = rankings_array_[i];
+        result.team_ = team;
+        result.rank_ = team->rank_;
+        result.accepted_count_ = team->getAcceptedCount();
+        result.penalty_ = team->getPenalty();
+        for (int problem_id = 0; problem_id < problems_; ++problem_id) {
+            result.cells_[problem_id] = team->getCell(problem_id);
+        }
+        sink.put(result);
+    }
+}
+
+void ICPCManagementSystem::renderRows(int begin, int end, OutputBuffer &output) {
+    const int chunks = thread_pool_->size() * kRenderChunksPerThread;
+    auto *buffers = new OutputBuffer[chunks];
+    for (int round = begin; round < end; round += chunks * kRenderChunkRows) {
+        int round_chunks = std::min(chunks, (end - round + kRenderChunkRows - 1) / kRenderChunkRows);
+        thread_pool_->parallelFor(round_chunks, 1, [this, round, end, buffers](int first, int last) {
+            for (int chunk = first; chunk < last; ++chunk) {
+                ResultFormatter formatter(buffers + chunk);
+                int chunk_begin = round + chunk * kRenderChunkRows;
+                putRows(chunk_begin, std::min(end, chunk_begin + kRenderChunkRows), formatter);
+            }
+        });
+        for (int chunk = 0; chunk < round_chunks; ++chunk) {
+            output.putString(buffers[chunk].data(), buffers[chunk].size());
+            buffers[chunk].consume(buffers[chunk].size());
+        }
+    }
+    delete[] buffers;
+}
+
+bool ICPCManagementSystem::executeCommand(const char *line) {
+    Command command;
+    if (!parseCommand(line, command)) {
+        // empty line
+        return true;
+    }
+    return execute(command);
+}
+
+bool ICPCManagementSystem::parseCommand(const char *line, Command &command) {
+    // the grammar of the commands, see the list of the supported commands
+    static constexpr CommandSyntax kGrammar[] = {
+            {"ADDTEAM", Command::kAddTeam, parseFields<kTeamName>},
+            {"START", Command::kStart, parseFields<kKeyword, kTime, kKeyword, kProblemCount>},
+            {"SUBMIT", Command::kSubmit, parseFields<kProblem, kKeyword, kTeamName, kKeyword, kStatus, kKeyword, kTime>},
+            {"FLUSH", Command::kFlush, parseFields<>},
+            {"FREEZE", Command::kFreeze, parseFields<>},
+            {"SCROLL", Command::kScroll, parseFields<>},
+            {"QUERY_RANKING", Command::kQueryRanking, parseFields<kTeamName>},
+            {"QUERY_SUBMISSION", Command::kQuerySubmission,
+             parseFields<kTeamName, kKeyword, kProblemFilter, kKeyword, kStatusFilter>},
+            {"QUERY_TOP", Command::kQueryTop, parseFields<kCount>},
+            {"PRINT_RANGE", Command::kPrintRange, parseFields<kCount, kTo>},
+            {"HISTORY_RANKING", Command::kHistoryRanking, parseFields<kTeamName, kTime>},
+            {"HISTORY_SCOREBOARD", Command::kHistoryScoreboard, parseFields<kTime>},
+            {"QUERY_HISTORY", Command::kQueryHistory,
+             parseFields<kTeamName, kKeyword, kProblemFilter, kKeyword, kStatusFilter, kKeyword, kCount>},
+            {"ANALYZE_PROBLEMS", Command::kAnalyzeProblems, parseFields<>},
+            {"ANALYZE_WRONG_ANSWERS", Command::kAnalyzeWrongAnswers, parseFields<kCount>},
+            {"QUERY_PROBLEM_STATS", Command::kQueryProblemStats, parseFields<>},
+            {"END", Command::kEnd, parseFields<>},
+    };
+    static constexpr KeywordTable<std::size(kGrammar)> kCommandTable{kGrammar, [](const CommandSyntax &syntax) {
+        return syntax.keyword_;
+    }};
+    static_assert(kCommandTable.found(), "no perfect hash for the command keywords");
+
+    int index = kCommandTable.find(scanToken(line));
+    if (index < 0) {
+        // empty or unknown
+        return false;
+    }
+    const CommandSyntax &syntax = kGrammar[index];
+    command.type_ = syntax.type_;
+    syntax.parse_(line, command);
+    return true;
+}
+
+bool ICPCManagementSystem::execute(const Command &command) {
+    switch (command.type_) {
+        case Command::kAddTeam:
+            addTeam(command.team_name_);
+            break;
+        case Command::kStart:
+            startContest(command.time_, command.problem_count_);
+            break;
+        case Command::kSubmit:
+            submitSolution(command.team_name_, command.problem_, command.result_, command.time_);
+            break;
+        case Command::kFlush:
+            flush();
+            break;
+        case Command::kFreeze:
+            freeze();
+            break;
+        case Command::kScroll:
+            scroll();
+            break;
+        case Command::kQueryRanking:
+            queryRanking(command.team_name_);
+            break;
+        case Command::kQuerySubmission:
+            querySubmission(command.team_name_, getProblemID(command.problem_), command.result_);
+            break;
+        case Command::kQueryTop:
+            queryTop(command.count_);
+            break;
+        case Command::kPrintRange:
+            printRange(command.count_, command.to_);
+            break;
+        case Command::kHistoryRanking:
+            queryHistoryRanking(command.team_name_, command.time_);
+            break;
+        case Command::kHistoryScoreboard:
+            printHistory(command.time_);
+            break;
+        case Command::kQueryHistory:
+            querySubmissionHistory(command.team_name_, getProblemID(command.problem_), command.result_, command.count_);
+            break;
+        case Command::kAnalyzeProblems:
+            analyzeProblems();
+            break;
+        case Command::kAnalyzeWrongAnswers:
+            analyzeWrongAnswers(command.count_);
+            break;
+        case Command::kQueryProblemStats:
+            queryProblemStats();
+            break;
+        case Command::kEnd:
+            putMessage(*sink_, Result::kEndSuccessfully);
+            return false;
+        case Command::kNone:
+            break;
+        case Command::kEndOfInput:
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,1769 @@
+#ifndef ACM_ICPC_MANAGEMENT_ICPC_MANAGEMENT_SYSTEM_H
+#define ACM_ICPC_MANAGEMENT_ICPC_MANAGEMENT_SYSTEM_H
+
+#include <climits>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <set>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "output_buffer.h"
+#include "keyword_table.h"
+#include "bucketed_ranking.h"
+#include "thread_pool.h"
+
+/**
+ * @brief The class of ICPCManagementSystem
+ * @details The class of ICPCManagementSystem, including the functions of adding teams, starting contest, submitting solutions, flushing scoreboard, freezing scoreboard, scrolling scoreboard, querying ranking, querying submission, printing rankings and handling commands
+ * It is the engine of the icpc library. The typed calls put their output as result records into the result sink, which renders them into an OutputBuffer by default, and nothing is read from or written to stdio.
+ */
+class ICPCManagementSystem {
+public:
+
+    /**
+     * @brief Construct a new ICPCManagementSystem object
+     * @details Construct a new ICPCManagementSystem object, initialize the contest_started_ to false, the frozen_ to false, the problems_ to 0, the team_count_ to 0, the teams_ to nullptr and the rankings_array_ to nullptr
+     *
+     * @param output the output buffer to write the information to
+     */
+    explicit ICPCManagementSystem(OutputBuffer *output) : contest_started_(false), frozen_(false), problems_(0),
+                                                          teams_(nullptr), team_rankings_(nullptr), team_count_(0),
+                                                          rankings_array_(nullptr),
+                                                          team_arena_(nullptr), formatter_(output), sink_(&formatter_),
+                                                          concurrent_reads_(false), snapshot_(nullptr), epoch_(1),
+                                                          delta_output_(nullptr), publish_count_(0),
+                                                          parallel_render_rows_(kDefaultParallelRenderRows),
+                                                          thread_pool_(nullptr), scroll_planner_(nullptr) {}
+
+    /**
+     * @brief The struct of command
+     * @details The struct of a decoded command line, produced by parseCommand and executed by execute
+     *
+     * @param type_ The type of the command
+     * @param problem_ The problem id of SUBMIT, QUERY_SUBMISSION and QUERY_HISTORY, -1 for ALL
+     * @param result_ The result id of SUBMIT, QUERY_SUBMISSION and QUERY_HISTORY, kStatusCount for ALL
+     * @param time_ The time of SUBMIT, HISTORY_RANKING and HISTORY_SCOREBOARD, or the duration of START
+     * @param problem_count_ The number of problems of START
+     * @param count_ The number of teams of QUERY_TOP, the first rank of PRINT_RANGE, the limit of QUERY_HISTORY, or the bucket width of ANALYZE_WRONG_ANSWERS
+     * @param to_ The last rank of PRINT_RANGE
+     * @param team_name_ The team name of ADDTEAM, SUBMIT, QUERY_RANKING, QUERY_SUBMISSION, HISTORY_RANKING and QUERY_HISTORY
+     */
+    struct Command;
+
+    /**
+     * @brief The struct of result
+     * @details The struct of a compact result record emitted by the system. Each record stands for one or a few lines of output, rendered by formatResult.
+     * The records refer to the teams by pointer and copy the data which may change later, so they can be rendered on another thread.
+     */
+    struct Result;
+
+    /**
+     * @brief The interface receiving the result records emitted by the system
+     */
+    class ResultSink {
+    public:
+        virtual ~ResultSink() = default;
+
+        virtual void put(const Result &result) = 0;
+    };
+
+    /**
+     * @brief The result sink rendering the records into an output buffer at once
+     */
+    class ResultFormatter : public ResultSink {
+    public:
+        explicit ResultFormatter(OutputBuffer *output) : output_(output) {}
+
+        void setOutput(OutputBuffer *output) {
+            output_ = output;
+        }
+
+        OutputBuffer *getOutput() const {
+            return output_;
+        }
+
+        void put(const Result &result) override {
+            formatResult(result, *output_);
+        }
+
+    private:
+        OutputBuffer *output_;
+    };
+
+    /**
+     * @brief Destroy the ICPCManagementSystem object
+     * @details Destroy the ICPCManagementSystem object, delete the rankings_array_, the teams_, the arenas of the teams, the ranking snapshots, the thread pool and the scroll planner
+     */
+    ~ICPCManagementSystem();
+
+    /**
+     * @brief Add a team
+     * @details Add a team, including adding the team name to the names_list_ and printing the information. The teams are created from names_list_ when the contest starts
+     *
+     * @param team_name the name of the team
+     * @log "[Info]Add successfully." if no error occurs
+     * @error If the contest has started, print "[Error]Add failed: competition has started." and return false
+     * @error If the team name is duplicated, print "[Error]Add failed: duplicated team name." and return false
+     * @return true if the team is added successfully, false if the team is not added successfully
+     */
+    bool addTeam(const std::string &team_name);
+
+    /**
+     * @brief Start the contest
+     * @details Start the contest, including initializing the problems_, the team_count_, the teams_, the rankings_array_, setting the contest_started_ to true and printing the information
+     * The teams are initialized in the order of names_list_ by the threads of the thread pool, with the per-team arrays carved from a few shared arenas, and the team name index is filled by the same threads.
+     * Since the teams are already in order, the tree of the first bucket of rankings_ is built bottom-up from their ranking records in O(teams) time.
+     *
+     * @param duration the duration of the contest
+     * @param problems the number of problems
+     * @log "[Info]Competition starts." if no error occurs
+     * @error If the contest has started, print "[Error]Start failed: competition has started." and return false
+     * @return true if the contest is started successfully, false if the contest is already started
+     */
+    bool startContest(int duration, int problems);
+
+    /**
+     * @brief Submit a solution
+     * @details Submit a solution, it will the submission data of the team. If the scoreboard has been frozen, it will update the frozen problem data of the team. Otherwise, it will push the submission into the submission list, waiting for flushing to update the problem data of the team
+     *
+     * @param team_name the name of the team
+     * @param problem_string the string of problem, including A, B, C, ..., X(the last problem)
+     * @param result_string the string of result, including Accepted, Wrong_Answer, Runtime_Error, Time_Limit_Exceed
+     * @param time the submission time
+     * @log Nothing
+     * @error It's guaranteed that the parameters are valid, and that the competition has started, so there is no error handling
+     * @return void
+     */
+    void
+    submitSolution(const std::string &team_name, const std::string &problem_string, const std::string &result_string,
+                   int time);
+
+    /**
+     * @brief Submit a solution with the decoded problem id and result id
+     * @details The same as submitSolution with strings, used when executing a parsed command
+     *
+     * @param team_name the name of the team
+     * @param problem_id the problem id
+     * @param result the result id
+     * @param time the submission time
+     */
+    void submitSolution(std::string_view team_name, int problem_id, int result, int time);
+
+    /**
+     * @brief The struct of a decoded submission of submitBatch
+     *
+     * @param team_name_ The name of the team
+     * @param problem_ The problem id
+     * @param result_ The result id
+     * @param time_ The submission time
+     */
+    struct SubmitRecord;
+
+    /**
+     * @brief Submit a batch of solutions
+     * @details The result is identical to calling submitSolution on the records one by one.
+     * Each name is looked up once, where a run of records of the same team shares one lookup, and the records of each team are chained in linear time without sorting, so that the per-team data of each team is written in one pass under one seqlock section.
+     * The submissions waiting for flushing and the submission history are still appended in the order of the records.
+     *
+     * @param records the array of records, in the order of submission
+     * @param count the number of records
+     * @log Nothing
+     * @error The same as submitSolution, there is no error handling
+     */
+    void submitBatch(const SubmitRecord *records, size_t count);
+
+    /**
+     * @brief Flush the scoreboard
+     * @details Flush the scoreboard, including updating the problem data of the teams, updating the rankings and updating the rankings_array_.
+     * Only the ranks passed by the teams which solved a problem since the last flush are updated, see updateRanks.
+     * If the scoreboard has been frozen, it will only proceed the submissions before the scoreboard is frozen.
+     * Otherwise, it will proceed all the submissions.
+     * @log "[Info]Flush scoreboard." if log is true
+     * @error It's guaranteed that the competition has started, so there is no error handling
+     * @param log whether to print the information
+     */
+    void flush(bool log = true);
+
+    /**
+     * @brief Freeze the scoreboard
+     * @details Freeze the scoreboard, including setting the frozen_ to true and logging.
+     * When the scoreboard is frozen, the problem data of the teams will be updated when scrolling.
+     * A problem will be frozen if the problem has not been accepted before the scoreboard is frozen, and a team has submitted a solution to the problem after the scoreboard is frozen.
+     * The scoreboard can be frozen many times.
+     *
+     * @log "[Info]Freeze scoreboard." if no error occurs
+     * @error If the scoreboard has been frozen, print "[Error]Freeze failed: scoreboard has been frozen." and return false
+     * @error It's guaranteed that the competition has started.
+     * @return true if the scoreboard is frozen successfully, false if the scoreboard is already frozen
+     */
+    bool freeze();
+
+    /**
+     * @brief Scroll the scoreboard
+     * @details Scroll the scoreboard, including updating the problem data of the teams, updating the rankings, updating the rankings_array_ and unfreeze the scoreboard.
+     * When scrolling, it will first print the scoreboard before scrolling. Note that a flushing will be performed before scrolling to proceed the submissions before the scoreboard is frozen.
+     * Then, it will proceed the submissions after the scoreboard is frozen. It will unfreeze the first frozen problem of the last team who has frozen problems, and update the problem data of the teams. If the rank of the team is changed, it will print the information.
+     * The output format is "[team_name] [replaced_team_name] [accepted_count] [penalty]"
+     * At last, it will print the scoreboard after scrolling.
+     * If the scroll is precomputed, see enableScrollPrecompute, the changes are taken from the precomputed sequence, and each team is unfrozen at once.
+     * @log "[Info]Scroll scoreboard." if no error occurs
+     * @error If the scoreboard has not been frozen, print "[Error]Scroll failed: scoreboard has not been frozen." and return false
+     * @return true if the scoreboard is scrolled successfully, false if the scoreboard is not frozen
+     */
+    bool scroll();
+
+    /**
+     * @brief Query the ranking of a team
+     * @details Query the ranking of a team after last flushing, including printing the information
+     *
+     * @param team_name the name of the team
+     * @log "[Info]Complete query ranking." if no error occurs
+     * @warning If the scoreboard has been frozen, print "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled."
+     * @error If the team is not found, print "[Error]Query ranking failed: cannot find the team." and return -1
+     * @error It's guaranteed that the competition has started.
+     * @return the rank of the team, -1 if the team is not found
+     */
+    int queryRanking(std::string_view team_name);
+
+    /**
+     * @brief Query the submission of a team
+     * @details Query the submission of a team, including printing the information. It will always print the latest result even if the scoreboard has been frozen, or the scoreboard has not been flushed in time.
+     * If the problem is not found, it will print "Cannot find any submission."
+     * Otherwise, it will print "[team_name] [problem_name] [result] [time]"
+     *
+     * @param team_name the name of the team
+     * @param problem_string the string of problem, including A, B, C, ..., X(the last problem) and ALL
+     * @param result_string the result, including Accepted, Wrong_Answer, Runtime_Error, Time_Limit_Exceed and ALL
+     * @log "[Info]Complete query submission." if no error occurs
+     * @error If the team is not found, print "[Error]Query submission failed: cannot find the team." and return false
+     * @error It's guaranteed that the competition has started.
+     * @return true if the submission is found, false otherwise
+     */
+    bool
+    querySubmission(const std::string &team_name, const std::string &problem_string, const std::string &result_string);
+
+    /**
+     * @brief Query the submission of a team with the decoded problem id and result id
+     * @details The same as querySubmission with strings, used when executing a parsed command
+     *
+     * @param team_name the name of the team
+     * @param problem_id the problem id, problems_ for ALL
+     * @param result the result id, kStatusCount for ALL
+     * @return true if the team is found, false otherwise
+     */
+    bool querySubmission(std::string_view team_name, int problem_id, int result);
+
+    /**
+     * @brief Query the top teams of the scoreboard
+     * @details Query the first k teams of the ranking after last flushing, in the same row format as printRankings, without rendering the other teams. It takes O(k) time.
+     * If k is larger than the number of teams, all the teams are printed.
+     *
+     * @param k the number of teams
+     * @log "[Info]Complete query top." if no error occurs
+     * @warning If the scoreboard has been frozen, print "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled."
+     * @error It's guaranteed that the competition has started.
+     * @return the number of teams printed
+     */
+    int queryTop(int k);
+
+    /**
+     * @brief Print a rank window of the scoreboard
+     * @details Print the teams ranked from `from` to `to` (both inclusive, 1-based) in the ranking after last flushing, in the same row format as printRankings. It takes O(to - from) time.
+     * The window is truncated to the number of teams, so a `to` beyond the number of teams prints up to the last team, and a `from` beyond it prints no team.
+     *
+     * @param from the first rank
+     * @param to the last rank, saturated to INT_MAX by the parser if it is beyond the range of int
+     * @log "[Info]Complete print range." if no error occurs
+     * @warning If the scoreboard has been frozen, print "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled."
+     * @error If from is less than 1 or to is less than from, print "[Error]Print range failed: invalid range."
+     * @return the number of teams printed, -1 if the range is invalid
+     */
+    int printRange(int from, int to);
+
+    /**
+     * @brief Query the ranking of a team at a past time
+     * @details Rebuild the scoreboard at the given time from the submission history, as if all the submissions no later than it had been flushed and none had been frozen, and find the ranking of the team in it.
+     * It replays the submissions from the nearest checkpoint before the time, and takes O(teams * problems) time.
+     *
+     * @param team_name the name of the team
+     * @param time the time
+     * @log "[Info]Complete query history ranking." if no error occurs
+     * @error If the competition has not started, print "[Error]Query history ranking failed: competition has not started." and return -1
+     * @error If the team is not found, print "[Error]Query history ranking failed: cannot find the team." and return -1
+     * @return the rank of the team at the time, -1 if the competition has not started or the team is not found
+     */
+    int queryHistoryRanking(std::string_view team_name, int time);
+
+    /**
+     * @brief Query the submissions of a team
+     * @details Query the submissions of a team matching the problem and the status, from the newest to the oldest, including printing the information.
+     * It takes O(result) time for a problem and a status, O(result) for ALL problems and ALL status, and O(problems + result * log(problems)) otherwise.
+     *
+     * @param team_name the name of the team
+     * @param problem_id the problem id, problems_ for ALL
+     * @param result the result id, kStatusCount for ALL
+     * @param limit the maximum number of submissions, 0 for no limit
+     * @log "[Info]Complete query history." if no error occurs, then a line for each submission, or "Cannot find any submission." if none
+     * @error If the competition has not started, print "[Error]Query history failed: competition has not started." and return -1
+     * @error If the team is not found, print "[Error]Query history failed: cannot find the team." and return -1
+     * @return the number of submissions printed, -1 if the competition has not started or the team is not found
+     */
+    int querySubmissionHistory(std::string_view team_name, int problem_id, int result, int limit);
+
+    /**
+     * @brief Analyze the submissions of each problem in the whole contest
+     * @details For each problem, print the number of accepted submissions, the number of submissions, and the first accepted submission (the first blood), including the frozen ones.
+     * It scans the columns of the submission history once, and the first blood scan stops as soon as every problem has been accepted.
+     *
+     * @log "[Info]Complete analyze problems." then "[problem_name] [accepted] [submissions] [team_name] [time]" for each problem, or "[problem_name] [accepted] [submissions] NONE" if it has not been accepted
+     * @error It's guaranteed that the competition has started.
+     */
+    void analyzeProblems();
+
+    /**
+     * @brief Analyze the wrong answer rate over the time
+     * @details Split the time into buckets of the given width, and print the number of submissions, the number of wrong answers and the wrong answer rate of each bucket, from time 0 to the last submission.
+     * The bucket boundaries are found by binary search on the time column, so each bucket is a contiguous range of the result column.
+     *
+     * @param width the width of a bucket, in minutes
+     * @log "[Info]Complete analyze wrong answers." then "[begin]-[end] [submissions] [wrong_answers] [rate]" for each bucket, where end is inclusive, at most INT_MAX, and the rate has 3 decimal places
+     * @error If the width is less than 1, print "[Error]Analyze wrong answers failed: invalid bucket width."
+     * @error It's guaranteed that the competition has started.
+     * @return the number of buckets printed, -1 if the width is invalid
+     */
+    int analyzeWrongAnswers(int width);
+
+    /**
+     * @brief Query the statistics of each problem on the scoreboard
+     * @details For each problem, print the number of teams which solved it, the number of attempts, the number of frozen attempts and the first solver. They are maintained incrementally when flushing, submitting after freezing and scrolling, so it takes O(problems) time.
+     * The same as the team rows, the statistics only count the flushed submissions, and the submissions of a frozen problem are only counted as frozen attempts until it is scrolled.
+     * The attempts are the submissions counted by the cells: the unaccepted submissions and the accepted submission of each team.
+     *
+     * @log "[Info]Complete query problem stats." then "[problem_name] [solved] [attempts] [frozen_attempts] [team_name] [time]" for each problem, or "[problem_name] [solved] [attempts] [frozen_attempts] NONE" if it has not been solved
+     * @warning If the scoreboard has been frozen, print "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled."
+     * @error It's guaranteed that the competition has started.
+     */
+    void queryProblemStats();
+
+    /**
+     * @brief Print the scoreboard at a past time
+     * @details Rebuild the scoreboard at the given time in the same way as queryHistoryRanking, and print it in the same row format as printRankings. It takes O(teams * (problems + log(teams))) time.
+     *
+     * @param time the time
+     * @log "[Info]Complete print history." if no error occurs
+     * @error If the competition has not started, print "[Error]Print history failed: competition has not started."
+
+     */
+    void printHistory(int time);
+
+    /**
+     * @brief Print the rankings
+     * @details Print the rankings
+     * It will print the information of each team, including the name, the rank, the number of accepted problems, the penalty and the problem data.
+     * When printing the problem data:
+     * If the problem has been accepted, it will print "+[unaccepted_submissions_before_accepted]". Specifically, if unaccepted_submissions_before_accepted is 0, it will print "+".
+     * If the problem has not been accepted, it will print "-[unaccepted_submissions_before_accepted]". Specifically, if unaccepted_submissions_before_accepted is 0, meaning that the problem has not been attempted, it will print ".".
+     * If the problem has been frozen, it will print "-[unaccepted_submissions_before_accepted]/[submissions_after_frozen]".
+     *
+     * @log Nothing
+     * @error It's guaranteed that the competition has started, so there is no error handling
+     * @param debug whether to print the information
+     */
+    void printRankings(bool debug = false);
+
+    /**
+     * @brief Put the rows of the scoreboard in the rank range [begin, end) into the result sink
+     * @details If the rows are rendered into an output buffer at once, and there are at least as many rows as set by setParallelRendering, the rows are rendered by several threads, see renderRows.
+     * @param begin the index of the first row in rankings_array_
+     * @param end the index after the last row in rankings_array_
+     */
+    void putRows(int begin, int end);
+
+    /**
+     * @brief Execute a command line
+     * @details Parse a command line and execute it, with the output put into the result sink. It is used by the stdin adapter in main() and the socket server.
+     *
+     * @param line the command line, ended by '\0' or a line break
+     * @return false if the command is "END", true otherwise
+     */
+    bool executeCommand(const char *line);
+
+    /**
+     * @brief Parse a command line
+     * @details Parse a command line into a command. It does not depend on the state of the system, so it can run on another thread.
+     * The command keyword is looked up in a perfect hash table built at compile time from the grammar table, whose entry holds the parser of the fields generated for the command, so the dispatch costs no branch on the command.
+     * Supported commands:
+     * ADDTEAM [team_name]  // add a team
+     * START DURATION [duration_time] PROBLEM [problem_count]  // start the contest
+     * SUBMIT [problem_name] BY [team_name] WITH [submit_status] AT [time]  // submit a solution
+     * FLUSH  // flush the scoreboard
+     * FREEZE  // freeze the scoreboard
+     * SCROLL  // scroll the scoreboard
+     * QUERY_RANKING [team_name]  // query the ranking of a team
+     * QUERY_SUBMISSION [team_name] WHERE PROBLEM=[problem_name] AND STATUS=[submit_status]  // query the submission of a team
+     * QUERY_TOP [k]  // query the first k teams of the scoreboard
+     * PRINT_RANGE [from] [to]  // print the teams ranked from `from` to `to` of the scoreboard
+     * HISTORY_RANKING [team_name] [time]  // query the ranking of a team at a past time
+     * HISTORY_SCOREBOARD [time]  // print the scoreboard at a past time
+     * QUERY_HISTORY [team_name] WHERE PROBLEM=[problem_name] AND STATUS=[submit_status] [LIMIT k]  // query the submissions of a team
+     * ANALYZE_PROBLEMS  // print the accepted count, the submission count and the first blood of each problem
+     * ANALYZE_WRONG_ANSWERS [width]  // print the wrong answer rate of each time bucket
+     * QUERY_PROBLEM_STATS  // print the solved count, the attempts and the first solver of each problem
+     * END  // end the contest
+     *
+     * @param line the command line, ended by '\0' or a line break
+     * @param command the command to store the result
+     * @return true if the line is a command, false if it is empty or unknown
+     */
+    static bool parseCommand(const char *line, Command &command);
+
+    /**
+     * @brief Execute a parsed command
+     * @param command the command
+     * @return false if the command is "END", true otherwise
+     */
+    bool execute(const Command &command);
+
+    /**
+     * @brief Render a result record
+     * @details Render a result record in the output format described in the README
+     * @param result the result record
+     * @param output the output buffer
+     */
+    static void formatResult(const Result &result, OutputBuffer &output);
+
+    /**
+     * @brief Set the output buffer
+     * @details Set the output buffer, the information of the following commands will be rendered into it at once
+     * @param output the output buffer
+     */
+    void setOutput(OutputBuffer *output) {
+        formatter_.setOutput(output);
+        sink_ = &formatter_;
+    }
+
+    /**
+     * @brief Set the result sink
+     * @details Set the result sink, the result records of the following commands will be put into it instead of an output buffer
+     * @param sink the result sink
+     */
+    void setResultSink(ResultSink *sink) {
+        sink_ = sink;
+    }
+
+    /**
+     * @brief Set the output buffer of the delta stream
+     * @details Each time the scoreboard is published (START, FLUSH, FREEZE and SCROLL), one JSON line is written into it, listing the teams whose rank, solved count, penalty or problem cells changed since the previous publish. The first line lists all the teams.
+     * The line has the form {"publish":1,"frozen":false,"teams":[{"name":"a","rank":1,"solved":1,"penalty":20,"cells":["+",".","-1"]}]}, and the cells are the same strings as in the scoreboard. The buffer is flushed after each line.
+     * It must be set before the contest starts.
+     * @param output the output buffer, nullptr to disable the delta stream
+     */
+    void setDeltaOutput(OutputBuffer *output) {
+        delta_output_ = output;
+    }
+
+    /**
+     * @brief Set the number of rows from which the scoreboard is rendered by several threads
+     * @details The output is the same as rendering by one thread. Nothing is rendered in parallel with a result sink other than the output buffer, or with only one thread, see setThreadCount.
+     * @param rows the minimum number of rows, 0 to always render by one thread
+     */
+    void setParallelRendering(int rows) {
+        parallel_render_rows_ = rows;
+    }
+
+    /**
+     * @brief Set the number of threads running the bulk phases
+     * @details The bulk phases are the initialization of the teams at START, the walk of all the ranks in a flush moving many teams, the rendering of large scoreboards and the copy of the ranks into a ranking snapshot.
+     * They run on a work-stealing thread pool owned by the system. With one thread, there is no pool, and they run on the calling thread as before.
+     * @param threads the number of threads, including the thread executing the commands, 1 by default
+     */
+    void setThreadCount(int threads) {
+        delete thread_pool_;
+        thread_pool_ = threads > 1 ? new ThreadPool(threads) : nullptr;
+    }
+
+    /**
+     * @brief Enable the speculative precomputation of the scroll
+     * @details Enable the speculative precomputation of the scroll. Between FREEZE and SCROLL, a background thread computes the changes SCROLL will print from a private copy of the ranking records and the frozen problems, taken when the scoreboard is frozen and kept up to date by the frozen submissions.
+     * A submission or a FLUSH during the frozen period invalidates the computed changes, and the thread starts over from the updated copy, so SCROLL waits at most for one computation, and usually for none.
+     * It should be called before the scoreboard is frozen.
+     */
+    void enableScrollPrecompute();
+
+    static const int kMaxReaders = 64; // the maximum number of threads calling executeReadOnlyCommand
+
+    /**
+     * @brief Enable the concurrent read path
+     * @details Enable the concurrent read path. From then on, an immutable ranking snapshot is published whenever the ranking or the frozen state visible to QUERY_RANKING changes, that is, at START, FLUSH, FREEZE and SCROLL.
+     * The snapshots are reclaimed by epochs, so the readers never wait for the writer. It should be called before the contest starts.
+     */
+    void enableConcurrentReads() {
+        concurrent_reads_ = true;
+    }
+
+    /**
+     * @brief Execute a read-only command without blocking the writer
+     * @details Execute QUERY_RANKING and QUERY_SUBMISSION on another thread than the one executing the other commands.
+     * QUERY_RANKING reads the ranking snapshot published at the last flush, and QUERY_SUBMISSION reads the submission slots of the team under its seqlock, so the output is the same as executeCommand.
+     * Many readers can run at the same time, while executeCommand can only be called by one thread at a time.
+     * It requires enableConcurrentReads.
+     *
+     * @param line the command line
+     * @param output the output buffer of the reader
+     * @param reader_id the id of the reader, in [0, kMaxReaders). Two readers running at the same time must have different ids.
+     * @return true if the command is executed, false if it is not a read-only command or the contest has not started, and it should be executed by executeCommand
+     */
+    bool executeReadOnlyCommand(const char *line, OutputBuffer &output, int reader_id);
+
+private:
+    static const int kStatusCount = 4; // the number of status, including Accepted, Wrong_Answer, Runtime_Error, Time_Limit_Exceed, ALL. ALL is used in querySubmission
+    static const int kMaxStringLength = 21; // the maximum length of team names and commands, including '\0'
+    static const int kMaxProblemCount = 26; // the maximum number of problems
+    static const int kDefaultParallelRenderRows = 1 << 15; // the default number of rows from which the scoreboard is rendered by several threads
+    static const int kParallelGrain = 1 << 12; // the number of teams in a task of the bulk phases on the thread pool
+    static const int kRenderChunksPerThread = 4; // the number of chunks rendered in a round per thread, so a slow chunk is balanced by stealing
+    static const int kRenderChunkRows = 1 << 12; // the number of rows rendered by a thread at a time, so the rendered chunks waiting to be written stay small
+    static const int kRankWalkRatio = 128; // updateRanks walks all the ranks if more than 1 / kRankWalkRatio of the teams have moved, about the cost of finding a rank over walking one
+
+    constexpr static const char *const kStatusString[kStatusCount + 1] = {"Accepted", "Wrong_Answer", "Runtime_Error",
+                                                                          "Time_Limit_Exceed",
+                                                                          "ALL"}; // the string of status, including Accepted, Wrong_Answer, Runtime_Error, Time_Limit_Exceed, ALL. ALL is used in querySubmission
+    constexpr static KeywordTable<kStatusCount + 1> kStatusTable{kStatusString, [](const char *status) {
+        return std::string_view(status);
+    }}; // the perfect hash table from the string of status to the result id
+    static_assert(kStatusTable.found(), "no perfect hash for the status");
+
+    /**
+     * @brief The field of a command line after the command keyword, read by parseField
+     */
+    enum Field : unsigned char {
+        kKeyword, // a fixed keyword such as BY, which is skipped
+        kTeamName, // the team name
+        kProblem, // the problem name
+        kProblemFilter, // PROBLEM=[problem_name] or PROBLEM=ALL
+        kStatus, // the submit status
+        kStatusFilter, // STATUS=[submit_status] or STATUS=ALL
+        kTime, // the time, or the duration of START
+        kProblemCount, // the number of problems of START
+        kCount, // the number of teams, the first rank, the limit or the bucket width
+        kTo // the last rank of PRINT_RANGE
+    };
+
+    /**
+     * @brief The struct of the syntax of a command
+     * @details The grammar of the commands is a constexpr table of such entries in parseCommand, from which the perfect hash table of the command keywords is built at compile time
+     *
+     * @param keyword_ The command keyword
+     * @param type_ The type of the command
+     * @param parse_ The parser of the fields after the keyword, generated by parseFields
+     */
+    struct CommandSyntax;
+
+    /**
+     * @brief The struct of submission
+     * @details The struct of submission, including the pointer to the team, the problem id, the result id and the time
+     *
+     * @param team_ The pointer to the team
+     * @param problem_ The problem id
+     * @param result_ The result id
+     * @param time_ The submission time
+     *
+     */
+    struct Submission;
+
+    /**
+     * @brief The struct of team
+     * @details The struct of team, including the name, the number of accepted problems, the number of frozen problems, the rank, the problems, the last submissions and the ranking record.
+     * It is the cold part of a team, and what compareTeam reads is kept in the ranking record.
+     *
+     * @param name_ The name of the team
+     * @param accepted_problems_ The bitmask of accepted problems, updated when flushing or scrolling
+     * @param frozen_problems_ The bitmask of frozen problems, updated when scrolling
+     * @param rank_ The rank, updated when flushing or scrolling
+     * @param problems_ The array of problems
+     * @param last_submission_ The array of last submissions, including the last submission of all status or problem, and the last submission of each status and problem
+     * @param ranking_ The ranking record of the team in team_rankings_
+     */
+    struct Team;
+
+    /**
+     * @brief The struct of the ranking record of a team
+     * @details The hot part of a team, everything compareTeam reads. The records of all the teams are kept in one contiguous array apart from the teams, and a record is aligned to the cache line, so comparing two teams touches one cache line of each unless many accepted times are tied.
+     * The records are in the order of teams_, which is the order of the names, so the tie is broken by the address, and the team of a record is found by its position without reading it.
+     *
+     * @param accepted_count_ The number of accepted problems, updated when flushing or scrolling
+     * @param penalty_ The penalty, updated when flushing or scrolling
+     * @param accepted_time_ The accepted time of the accepted problems, in descending order, updated when flushing or scrolling
+     */
+    struct TeamRanking;
+
+    /**
+     * @brief The struct of team name
+     * @details The struct of team name, kept inline in a 24-byte slot with its length in the last byte, so reading a name never leaves the team, and printing it is a copy of a constant size.
+     * A name is at most kMaxStringLength - 1 characters, like the tokens of the command lines.
+     *
+     * @param data_ The characters, padded with '\0'
+     * @param length_ The length
+     */
+    struct TeamName {
+        static const int kCapacity = 23; // the number of characters the slot can hold
+
+        char data_[kCapacity] = {};
+        unsigned char length_ = 0;
+
+        inline void assign(std::string_view name) {
+            length_ = static_cast<unsigned char>(std::min(name.size(), static_cast<size_t>(kCapacity)));
+            memcpy(data_, name.data(), length_);
+            memset(data_ + length_, 0, kCapacity - length_);
+        }
+
+        inline std::string_view view() const {
+            return {data_, length_};
+        }
+
+        inline bool operator==(std::string_view name) const {
+            return name.size() == length_ && memcmp(data_, name.data(), length_) == 0;
+        }
+    };
+
+    static_assert(sizeof(TeamName) == 24, "a team name takes 24 bytes");
+    static_assert(TeamName::kCapacity >= kMaxStringLength - 1, "a team name fits in the slot");
+
+    /**
+     * @brief The class of team name index
+     * @details The class of team name index, an open addressing hash table from the team name to the pointer to the team, with linear probing.
+     * It is filled once when the contest starts, by many threads at the same time, and only read afterwards.
+     */
+    class TeamNameIndex {
+    public:
+        TeamNameIndex() : mask_(0), slots_(nullptr) {}
+
+        TeamNameIndex(const TeamNameIndex &) = delete;
+
+        TeamNameIndex &operator=(const TeamNameIndex &) = delete;
+
+        ~TeamNameIndex() {
+            delete[] slots_;
+        }
+
+        /**
+         * @brief Allocate the empty slots for the teams, with a load factor no more than 1/2
+         * @param count the number of teams
+         */
+        void reserve(int count);
+
+        /**
+         * @brief Insert a team, which can be called by many threads at the same time
+         * @param team the pointer to the team, whose name is unique
+         */
+        void insert(Team *team);
+
+        /**
+         * @brief Find a team by name
+         * @param name the name of the team
+         * @return The pointer to the team, nullptr if not found
+         */
+        Team *find(std::string_view name) const;
+
+    private:
+        size_t mask_; // the number of slots - 1
+        std::atomic<Team *> *slots_; // the slots, nullptr for empty
+    };
+
+    /**
+     * @brief The class of submission list of a team
+     * @details The class of submission list of a team, a columnar store of all the submissions of the team in time order, 8 bytes per submission: the time, and a packed word of the problem id, the result id and the index of the previous submission with the same problem and result.
+     * The newest submission of each problem and result is kept in heads_, so the submissions matching a problem and a result are a linked list from there, and the submissions matching ALL are a merge of such lists.
+     */
+    class SubmissionList {
+    public:
+        SubmissionList() : problems_(0), heads_(nullptr) {}
+
+        /**
+         * @brief Initialize the empty list
+         * @param problems the number of problems
+         * @param heads the array of kStatusCount * problems ints for the newest submissions, owned by the caller
+         */
+        void initialize(int problems, int *heads) {
+            problems_ = problems;
+            heads_ = heads;
+            std::fill(heads_, heads_ + kStatusCount * problems, -1);
+        }
+
+        /**
+         * @brief Append a submission, whose time is no less than the time of the previous one
+         * @param problem_id the problem id
+         * @param result the result id
+         * @param time the submission time
+         */
+        void append(int problem_id, int result, int time) {
+            int &head = heads_[problem_id * kStatusCount + result];
+            times_.push_back(time);
+            links_.push_back(static_cast<unsigned int>(head + 1) << kLinkShift |
+                             static_cast<unsigned int>(problem_id) << kProblemShift | result);
+            head = static_cast<int>(times_.size()) - 1;
+        }
+
+        int getTime(int index) const {
+            return times_[index];
+        }
+
+        int getProblem(int index) const {
+            return static_cast<int>(links_[index] >> kProblemShift & kProblemMask);
+        }
+
+        int getResult(int index) const {
+            return static_cast<int>(links_[index] & kResultMask);
+        }
+
+        /**
+         * @brief Visit the submissions matching the problem and the result, from the newest to the oldest
+         * @param problem_id the problem id, problems_ for ALL
+         * @param result the result id, kStatusCount for ALL
+         * @param limit the maximum number of submissions, 0 for no limit
+         * @param visit the function called with the index of each submission
+         * @return The number of submissions visited
+         */
+        template<typename Function>
+        int visit(int problem_id, int result, int limit, Function visit) const;
+
+    private:
+        static const int kProblemShift = 2; // the lowest 2 bits are the result id
+        static const int kLinkShift = 7; // the next 5 bits are the problem id, and the highest 25 bits are the index of the previous submission plus 1
+        static const unsigned int kResultMask = (1u << kProblemShift) - 1;
+        static const unsigned int kProblemMask = (1u << (kLinkShift - kProblemShift)) - 1;
+
+        /**
+         * @brief Get the index of the previous submission with the same problem and result
+         * @return The index, -1 if none
+         */
+        int getPrevious(int index) const {
+            return static_cast<int>(links_[index] >> kLinkShift) - 1;
+        }
+
+        int problems_; // the number of problems
+        int *heads_; // the index of the newest submission of each problem and result, -1 if none
+        std::vector<int> times_; // the time of each submission
+        std::vector<unsigned int> links_; // the packed problem id, result id and previous index of each submission
+    };
+
+    /**
+     * @brief The class of submission history
+     * @details The class of submission history, an append-only columnar table of all the submissions in time order, and checkpoints of the unfrozen problem cells of all the teams.
+     * The time, the team id, the problem id and the result id are kept in separate packed arrays, so the contest-wide scans read only the columns they need, in tight loops the compiler can vectorize.
+     * A checkpoint is taken every max(teams * problems, kMinCheckpointInterval) submissions, so the checkpoints take no more memory than the log, and rebuilding the cells at any time replays no more than one interval of the log.
+     */
+    class SubmissionHistory {
+    public:
+        /**
+         * @brief The struct of the problem cell of a team in the history
+         *
+         * @param unaccepted_submissions_ The number of unaccepted submissions before the problem is accepted
+         * @param accepted_time_ The accepted time, 0 if the problem has not been accepted
+         */
+        struct Cell {
+            int unaccepted_submissions_;
+            int accepted_time_;
+        };
+
+        SubmissionHistory() : teams_(0), problems_(0), interval_(kMinCheckpointInterval) {}
+
+        /**
+         * @brief Clear the history, and prepare the cells for the teams
+         * @param teams the number of teams
+         * @param problems the number of problems
+         */
+        void reset(int teams, int problems);
+
+        /**
+         * @brief Append a submission, whose time is no less than the time of the previous one
+         * @param team_id the position of the team in teams_
+         * @param problem_id the problem id
+         * @param result the result id
+         * @param time the submission time
+         */
+        void append(int team_id, int problem_id, int result, int time);
+
+        /**
+         * @brief Rebuild the cells of all the teams after all the submissions no later than the time
+         * @param time the time
+         * @param cells the array of teams * problems cells, indexed by team_id * problems + problem_id
+         */
+        void replay(int time, Cell *cells) const;
+
+        /**
+         * @brief Get the number of submissions
+         */
+        size_t size() const {
+            return time_column_.size();
+        }
+
+        /**
+         * @brief Get the number of submissions no later than the time
+         * @param time the time
+         * @return The index of the first submission later than the time
+         */
+        size_t upperBound(int time) const {
+            return std::upper_bound(time_column_.begin(), time_column_.end(), time) - time_column_.begin();
+        }
+
+        int getTime(size_t index) const {
+            return time_column_[index];
+        }
+
+        int getTeam(size_t index) const {
+            return team_column_[index];
+        }
+
+        /**
+         * @brief Count the submissions in [begin, end) of each problem and result
+         * @param begin the index of the first submission
+         * @param end the index after the last submission
+         * @param counts the counts of each problem and result, added to
+         */
+        void countByProblem(size_t begin, size_t end, long long counts[kMaxProblemCount][kStatusCount]) const;
+
+        /**
+         * @brief Find the first accepted submission of each problem
+         * @param first the index of the first accepted submission of each problem, -1 if none
+         */
+        void findFirstAccepted(long long first[kMaxProblemCount]) const;
+
+        /**
+         * @brief Count the submissions and the wrong answers in [begin, end)
+         * @param begin the index of the first submission
+         * @param end the index after the last submission
+         * @param total the number of submissions
+         * @param wrong the number of wrong answers
+         */
+        void countWrongAnswers(size_t begin, size_t end, int &total, int &wrong) const;
+
+    private:
+        static const int kMinCheckpointInterval = 1 << 12; // the minimum number of submissions between two checkpoints
+
+        /**
+         * @brief Apply a submission to the cells
+         * @param index the index of the submission
+         */
+        void apply(size_t index, Cell *cells) const {
+            Cell &cell = cells[static_cast<size_t>(team_column_[index]) * problems_ + problem_column_[index]];
+            if (cell.accepted_time_) {
+                // the submissions after the problem is accepted are ignored when flushing
+                return;
+            }
+            if (result_column_[index] == 0) {
+                cell.accepted_time_ = time_column_[index];
+            } else {
+                ++cell.unaccepted_submissions_;
+            }
+        }
+
+        int teams_; // the number of teams
+        int problems_; // the number of problems
+        size_t interval_; // the number of submissions between two checkpoints
+        std::vector<int> time_column_; // the time of each submission, in non-decreasing order
+        std::vector<int> team_column_; // the team id of each submission
+        std::vector<unsigned char> problem_column_; // the problem id of each submission
+        std::vector<unsigned char> result_column_; // the result id of each submission
+        std::vector<Cell> current_; // the cells after all the submissions
+        std::vector<std::vector<Cell>> checkpoints_; // checkpoints_[i] is the cells after the first (i + 1) * interval_ submissions
+    };
+
+    /**
+     * @brief The struct of a row of the scoreboard rebuilt from the submission history
+     *
+     * @param team_ The position of the team in teams_
+     * @param accepted_count_ The number of accepted problems
+     * @param penalty_ The penalty
+     * @param accepted_time_ The accepted time of the accepted problems, in descending order
+     */
+    struct HistoryRow {
+        int team_;
+        int accepted_count_;
+        int penalty_;
+        int accepted_time_[kMaxProblemCount];
+
+        /**
+         * @brief Compare two rows by the same rule as compareTeam
+         * @return true if this row is better than the other one, false otherwise
+         */
+        bool operator<(const HistoryRow &other) const {
+            if (accepted_count_ != other.accepted_count_) {
+                return accepted_count_ > other.accepted_count_;
+            }
+            if (penalty_ != other.penalty_) {
+                return penalty_ < other.penalty_;
+            }
+            for (int i = 0; i < accepted_count_; ++i) {
+                if (accepted_time_[i] != other.accepted_time_[i]) {
+                    return accepted_time_[i] < other.accepted_time_[i];
+                }
+            }
+            return team_ < other.team_;
+        }
+    };
+
+    /**
+     * @brief The functor of comparing teams
+     * @details The functor of comparing teams
+     * the rule of comparing teams:
+     * 1. the number of accepted problems, the more the better
+     * 2. the penalty, the less the better
+     * 3. the accepted time of each problem, in ascending order, the less the better
+     * 4. the name of the team, in alphabetical order, the less the better. Since the teams_ array stores the teams in the order of the names, the pointer to the team is used to compare the names
+     * Since the names of the teams are unique, no more comparison is needed.
+     * The first two rules are packed into one integer by getKey, which is the key of rankings_.
+     *
+     * @param a the pointer to the first team
+     * @param b the pointer to the second team
+     * @return true if the first team is better than the second team, false otherwise
+     */
+    struct compareTeam {
+        inline bool operator()(const TeamRanking *a, const TeamRanking *b) const;
+
+        inline bool operator()(const Team *a, const Team *b) const;
+
+        /**
+         * @brief Pack the number of accepted problems and the penalty, a less key for a better team
+         */
+        static inline unsigned long long getKey(const TeamRanking *ranking);
+    };
+
+    /**
+     * @brief The struct of the statistics of a problem on the scoreboard
+     *
+     * @param solved_ The number of teams which solved the problem
+     * @param attempts_ The number of the submissions counted by the unfrozen cells
+     * @param frozen_attempts_ The number of the submissions counted by the frozen cells
+     * @param first_solver_ The team which solved the problem the earliest, nullptr if none. The tie is broken by the name.
+     * @param first_time_ The accepted time of the first solver
+     */
+    struct ProblemStats {
+        int solved_ = 0;
+        int attempts_ = 0;
+        int frozen_attempts_ = 0;
+        const Team *first_solver_ = nullptr;
+        int first_time_ = 0;
+
+        /**
+         * @brief Count a team which solved the problem
+         * @param team the pointer to the team, whose position in teams_ is in the order of the names
+         * @param time the accepted time
+         */
+        void addSolver(const Team *team, int time) {
+            ++solved_;
+            if (first_solver_ == nullptr || time < first_time_ || (time == first_time_ && team < first_solver_)) {
+                first_solver_ = team;
+                first_time_ = time;
+            }
+        }
+    };
+
+    /**
+     * @brief The struct of ranking snapshot
+     * @details The struct of ranking snapshot, an immutable copy of what QUERY_RANKING reads, published for the concurrent readers
+     *
+     * @param frozen_ Whether the scoreboard is frozen
+     * @param ranks_ The rank of each team after the last flushing, indexed by the position in teams_
+     */
+    struct RankingSnapshot {
+        bool frozen_;
+        std::vector<int> ranks_;
+    };
+
+    /**
+     * @brief The class of scroll planner
+     * @details The class of scroll planner, which runs the scroll on a private copy of the ranking records and the frozen problems on a background thread, see enableScrollPrecompute. It is defined in the source file, since only flush, freeze, scroll and the frozen submissions use it.
+     */
+    class ScrollPlanner;
+
+    /**
+     * @brief The struct of the epoch of a reader
+     * @details The epoch observed by a reader when it starts reading a snapshot, 0 if it is not reading. Each one takes a cache line to avoid false sharing.
+     */
+    struct alignas(64) ReaderEpoch {
+        std::atomic<unsigned long long> epoch_{0};
+    };
+
+    std::set<std::string> names_list_; // the set of team names
+    BucketedRanking<TeamRanking *, compareTeam, kMaxProblemCount + 1> rankings_; // the ranking records of the teams in one B+-tree per number of accepted problems, sorted by the number of accepted problems, the penalty and the accepted time
+    bool contest_started_; // whether the contest has started
+    bool frozen_; // whether the scoreboard has been frozen. The scoreboard can be frozen many times.
+    int problems_; // the number of problems
+    Team *teams_; // the array of teams
+    TeamRanking *team_rankings_; // the array of the ranking records of the teams, in the order of teams_
+    int team_count_; // the number of teams
+    Team **rankings_array_{}; // the array of teams, sorted by the rank, updated when flushing or scrolling
+    std::vector<Team *> moved_teams_; // the teams which have moved up in rankings_ since the ranks were updated, see updateRanks
+    std::vector<std::pair<int, int>> moved_ranks_; // the new rank and the old rank of each moved team, used by updateRanks
+    void *team_arena_; // the per-team arrays of all the teams, carved by Team::initialize
+    TeamNameIndex name_index_; // the index from team name to team pointer, built when the contest starts
+
+    std::vector<Submission> submissions_; // the vector of submissions, waiting for flushing
+    ResultFormatter formatter_; // the result sink rendering into the output buffer set by setOutput
+    ResultSink *sink_; // the result sink receiving the result records
+
+    bool concurrent_reads_; // whether the ranking snapshot is published for the concurrent readers
+    std::atomic<RankingSnapshot *> snapshot_; // the latest ranking snapshot, nullptr before the contest starts
+    std::atomic<unsigned long long> epoch_; // the global epoch, increased when a snapshot is retired
+    ReaderEpoch reader_epochs_[kMaxReaders]; // the epoch of each reader
+    std::vector<std::pair<RankingSnapshot *, unsigned long long>> retired_snapshots_; // the retired snapshots and the epochs when they are retired
+
+    OutputBuffer *delta_output_; // the output buffer of the delta stream, nullptr if disabled
+    long long publish_count_; // the number of publishes written into the delta stream
+    int parallel_render_rows_; // the minimum number of rows rendered by several threads, 0 to always render by one thread
+    ThreadPool *thread_pool_; // the thread pool running the bulk phases, nullptr with one thread
+    ScrollPlanner *scroll_planner_; // the planner precomputing the scroll, nullptr if disabled
+
+    SubmissionHistory history_; // the history of all the submissions, used by the queries of past scoreboards
+    ProblemStats problem_stats_[kMaxProblemCount]; // the statistics of each problem, updated when flushing, submitting after freezing and scrolling
+
+    std::vector<Team *> batch_teams_; // the teams of the current batch of submitBatch, in the order of their first records
+    std::vector<int> batch_next_; // the next record of the same team of each record of submitBatch, -1 for the last one
+
+    /**
+     * @brief Update the data of a team for a submission, except the last submission slots
+     * @details Update the frozen problem data if the scoreboard has been frozen, and append the submission into the submission list of the team. The last submission slots are updated by the caller under the seqlock of the team.
+     */
+    inline void applySubmission(Team *team, int problem_id, int result, int time);
+
+    /**
+     * @brief Pass the frozen problem of a team to the scroll planner after a submission
+     */
+    void precomputeSubmission(const Team *team, int problem_id);
+
+    /**
+     * @brief Unfreeze all the frozen problems of all the teams, in the order of the teams, without printing the changes
+     * @details The final state is the same as unfreezing them one by one in the order of scroll, since the statistics of the problems do not depend on the order.
+     */
+    void unfreezeTeams();
+
+    /**
+     * @brief Store a submission into the last submission slots of its team
+     * @details The caller must hold the seqlock of the team
+     */
+    inline void storeLastSubmission(const Submission &submission);
+
+    /**
+     * @brief Publish a ranking snapshot of the current ranks and frozen state
+     * @details Publish a ranking snapshot, and free the retired snapshots which no reader can still be reading. Nothing happens if the concurrent read path is not enabled.
+     */
+    void publishSnapshot();
+
+    /**
+     * @brief Write the changes since the previous publish into the delta stream
+     * @details Only the teams whose cells changed since the previous publish, when flushing their submissions, submitting to a frozen problem or revealing their frozen problems, may change their solved count, penalty and cells, and they are compared by the digest of their row. Other teams are checked by the rank only.
+     */
+    void publishDelta();
+
+    /**
+     * @brief Put a problem cell of the scoreboard
+     * @param cell the cell encoded by Team::getCell
+     */
+    static void putCell(OutputBuffer &output, unsigned long long cell);
+
+    /**
+     * @brief Put the name of a team
+     */
+    static void putTeamName(OutputBuffer &output, const Team *team);
+
+    /**
+     * @brief Rebuild the rows of the scoreboard at a past time from the submission history
+     * @param time the time
+     * @param cells the array of team_count_ * problems_ cells, filled by SubmissionHistory::replay
+     * @param rows the array of team_count_ rows, in the order of teams_
+     */
+    void buildHistoryRows(int time, SubmissionHistory::Cell *cells, HistoryRow *rows) const;
+
+    /**
+     * @brief Put a message record into a result sink
+     */
+    static void putMessage(ResultSink &sink, int message);
+
+    /**
+     * @brief Put the record of a successful QUERY_RANKING into a result sink
+     */
+    static void putRanking(ResultSink &sink, const Team *team, int rank, bool frozen);
+
+    /**
+     * @brief Put the record of a successful QUERY_SUBMISSION into a result sink
+     */
+    static void putSubmission(ResultSink &sink, const Team *team, const Submission &submission);
+
+    /**
+     * @brief Get the team of a ranking record
+     */
+    inline Team *getTeam(const TeamRanking *ranking) const;
+
+    /**
+     * @brief Update rank_ and rankings_array_ after the teams in moved_teams_ have moved up in rankings_
+     * @details A team only moves up when it solves a problem, and the other teams keep their order, so a team changes its rank only if a moved team passes it, and the ranks out of the ranges from the new rank to the old rank of the moved teams are unchanged.
+     * The new rank is the number of teams in the buckets of more accepted problems plus the rank in the bucket, and the ranks in the union of the ranges are walked in rankings_.
+     * If many teams have moved, finding their ranks costs more than walking all the ranks, which is done instead.
+     */
+    void updateRanks();
+
+    /**
+     * @brief Walk rankings_ from a rank to another, and set rank_ and rankings_array_
+     */
+    void setRanks(int begin, int end);
+
+    /**
+     * @brief Put the rows of the scoreboard in the rank range [begin, end) into a result sink by the calling thread
+     */
+    void putRows(int begin, int end, ResultSink &sink) const;
+
+    /**
+     * @brief Render the rows of the scoreboard in the rank range [begin, end) into an output buffer on the thread pool
+     * @details The rows are split into chunks of kRenderChunkRows rows. In each round, the threads render kRenderChunksPerThread chunks each, every chunk into its own buffer, and the buffers are then copied into the output in the order of the chunks, so the output is the same as rendering by one thread.
+     * A row only reads its team, which is not changed while rendering, so the threads share nothing but the output of the round.
+     */
+    void renderRows(int begin, int end, OutputBuffer &output);
+
+    /**
+     * @brief Get the pointer to the team
+     * @param team_name the name of the team
+     * @return The pointer to the team
+     */
+    inline Team *getTeamPointer(std::string_view team_name) const {
+        return name_index_.find(team_name.substr(0, kMaxStringLength - 1));
+    }
+
+    /**
+     * @brief Run a function on the indices in [0, count) with the thread pool, in tasks of kParallelGrain indices
+     * @details It only runs on the calling thread if there is no thread pool or there are few indices.
+     *
+     * @param count the number of indices
+     * @param function the function called with the beginning and the end of a task
+     */
+    template<typename Function>
+    void parallelFor(int count, Function function) {
+        if (thread_pool_ == nullptr) {
+            function(0, count);
+            return;
+        }
+        thread_pool_->parallelFor(count, kParallelGrain, function);
+    }
+
+    /**
+     * @brief Get the result id
+     * @param result_string the string of result, including Accepted, Wrong_Answer, Runtime_Error, Time_Limit_Exceed, ALL
+     * @return The result id, 0 for Accepted, 1 for Wrong_Answer, 2 for Runtime_Error, 3 for Time_Limit_Exceed, 4 for ALL
+     */
+    static int getResultID(std::string_view result_string) {
+        return std::max(0, kStatusTable.findKnown(result_string));
+    }
+
+    /**
+     * @brief Get the problem id
+     * @param problem_string the string of problem, including A, B, C, ..., X(the last problem), and ALL. ALL is used in querySubmission
+     * @return The problem id, 0 for A, 1 for B, 2 for C, ..., problems_ - 1 for X, problems_ for ALL
+     */
+    int getProblemID(const std::string &problem_string) const {
+        // if the problem_string is "ALL", return the number of problems
+        return problem_string.size() > 1 ? problems_ : problem_string[0] - 'A';
+    }
+
+    /**
+     * @brief Get the problem id of a parsed command
+     * @param problem_id the problem id in the command, -1 for ALL
+     * @return The problem id, problems_ for ALL
+     */
+    int getProblemID(int problem_id) const {
+        return problem_id < 0 ? problems_ : problem_id;
+    }
+
+    /**
+     * @brief Get the problem name
+     * @param problem_id the problem id
+     * @return The problem name, A for 0, B for 1, C for 2, ..., X for problems_ - 1
+     */
+    static char getProblemName(int problem_id) {
+        return 'A' + problem_id;
+    }
+
+    /**
+     * @brief Read a token separated by spaces from a command line
+     * @details Read a token from the cursor, and move the cursor to the end of the token. The token is truncated to kMaxStringLength - 1 characters.
+     * @param cursor the cursor of the command line
+     * @param token the buffer to store the token, with a size of kMaxStringLength
+     * @return true if a token is read, false if the line has ended
+     */
+    static bool readToken(const char *&cursor, char *token) {
+        std::string_view view = scanToken(cursor);
+        size_t length = std::min(view.size(), static_cast<size_t>(kMaxStringLength - 1));
+        memcpy(token, view.data(), length);
+        token[length] = '\0';
+        return length != 0;
+    }
+
+    /**
+     * @brief Scan a token separated by spaces from a command line without copying it
+     * @details The tokens consist of printable characters, so any character no greater than ' ' ends a token, which takes one comparison per character.
+     * The spaces before the token are skipped within the line, so a line ended by a line break instead of '\0' can be parsed in place.
+     * @param cursor the cursor of the command line, moved to the end of the token
+     * @return The token, empty if the line has ended
+     */
+    static std::string_view scanToken(const char *&cursor) {
+        while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') {
+            ++cursor;
+        }
+        const char *begin = cursor;
+        while (static_cast<unsigned char>(*cursor) > ' ') {
+            ++cursor;
+        }
+        return {begin, static_cast<size_t>(cursor - begin)};
+    }
+
+    /**
+     * @brief Read a field of a command line
+     * @details Each field is a branch of if constexpr, so the parser of a command generated by parseFields has no branch on the grammar at runtime
+     * @tparam kField the field
+     * @param cursor the cursor of the command line, moved to the end of the field
+     * @param command the command to store the field
+     */
+    template<Field kField>
+    static void parseField(const char *&cursor, Command &command);
+
+    /**
+     * @brief Read the fields of a command line after the command keyword
+     * @tparam kFields the fields in order
+     * @param cursor the cursor of the command line, after the command keyword
+     * @param command the command to store the fields
+     */
+    template<Field... kFields>
+    static void parseFields(const char *cursor, Command &command) {
+        (parseField<kFields>(cursor, command), ...);
+    }
+
+    /**
+     * @brief Skip the name of an assignment such as "PROBLEM=" in a command line
+     * @details The name is searched within the next token, so the cursor never leaves the line
+     * @param cursor the cursor of the command line, moved to the character after '='
+     */
+    static void skipAssignment(const char *&cursor) {
+        while (*cursor == ' ' || *cursor == '\t') {
+            ++cursor;
+        }
+        while (static_cast<unsigned char>(*cursor) > ' ' && *cursor != '=') {
+            ++cursor;
+        }
+        if (*cursor == '=') {
+            ++cursor;
+        }
+    }
+
+    /**
+     * @brief Read a non-negative integer from a command line
+     * @details An integer beyond the range of int, such as the last rank of PRINT_RANGE, is saturated to INT_MAX instead of overflowing
+     * @param cursor the cursor of the command line, moved to the end of the integer
+     * @return the integer
+     */
+    static int readInt(const char *&cursor) {
+        while (*cursor == ' ') {
+            ++cursor;
+        }
+        long long value = 0;
+        while (*cursor >= '0' && *cursor <= '9') {
+            if (value <= INT_MAX) {
+                value = value * 10 + (*cursor - '0');
+            }
+            ++cursor;
+        }
+        return value > INT_MAX ? INT_MAX : static_cast<int>(value);
+    }
+};
+
+struct ICPCManagementSystem::Command {
+    enum Type : unsigned char {
+        kNone, kAddTeam, kStart, kSubmit, kFlush, kFreeze, kScroll, kQueryRanking, kQuerySubmission, kQueryTop, kPrintRange, kHistoryRanking, kHistoryScoreboard, kQueryHistory, kAnalyzeProblems,
+        kAnalyzeWrongAnswers, kQueryProblemStats, kEnd,
+        kEndOfInput // the end of the input without END, only used to stop the pipeline
+    };
+
+    Type type_ = kNone;
+    int problem_ = 0;
+    int result_ = 0;
+    int time_ = 0;
+    int problem_count_ = 0;
+    int count_ = 0;
+    int to_ = 0;
+    char team_name_[kMaxStringLength] = {};
+};
+
+struct ICPCManagementSystem::CommandSyntax {
+    std::string_view keyword_;
+    Command::Type type_;
+    void (*parse_)(const char *cursor, Command &command);
+};
+
+template<ICPCManagementSystem::Field kField>
+inline void ICPCManagementSystem::parseField(const char *&cursor, Command &command) {
+    if constexpr (kField == kKeyword) {
+        scanToken(cursor);
+    } else if constexpr (kField == kTeamName) {
+        readToken(cursor, command.team_name_);
+    } else if constexpr (kField == kProblem) {
+        command.problem_ = *scanToken(cursor).data() - 'A';
+    } else if constexpr (kField == kProblemFilter) {
+        skipAssignment(cursor);
+        std::string_view problem = scanToken(cursor);
+        command.problem_ = problem.size() > 1 ? -1 : *problem.data() - 'A';
+    } else if constexpr (kField == kStatus) {
+        command.result_ = getResultID(scanToken(cursor));
+    } else if constexpr (kField == kStatusFilter) {
+        skipAssignment(cursor);
+        command.result_ = getResultID(scanToken(cursor));
+    } else if constexpr (kField == kTime) {
+        command.time_ = readInt(cursor);
+    } else if constexpr (kField == kProblemCount) {
+        command.problem_count_ = readInt(cursor);
+    } else if constexpr (kField == kCount) {
+        command.count_ = readInt(cursor);
+    } else if constexpr (kField == kTo) {
+        command.to_ = readInt(cursor);
+    }
+}
+
+struct ICPCManagementSystem::SubmitRecord {
+    std::string_view team_name_;
+    int problem_ = 0;
+    int result_ = 0;
+    int time_ = 0;
+};
+
+struct ICPCManagementSystem::Result {
+    /**
+     * @brief The type of result record
+     * @details kMessage: a fixed line in kMessageString, given by message_
+     * kRanking: the result of QUERY_RANKING, given by team_, rank_ and frozen_
+     * kSubmission: the result of QUERY_SUBMISSION, given by team_, problem_, result_ and time_. problem_ is -1 if no submission is found
+     * kScrollChange: a line of ranking change when scrolling, given by team_, replaced_team_, accepted_count_ and penalty_
+     * kRow: a row of the scoreboard, given by team_, rank_, accepted_count_, penalty_, problem_count_ and cells_
+     * kHistoryRanking: the result of HISTORY_RANKING, given by team_, rank_ and time_
+     * kHistorySubmission: a submission of QUERY_HISTORY, given by team_, problem_, result_ and time_
+     * kProblemAnalysis: a problem of ANALYZE_PROBLEMS, given by problem_, accepted_count_, total_, and team_ and time_ of the first blood. team_ is nullptr if the problem has not been accepted
+     * kBucketAnalysis: a bucket of ANALYZE_WRONG_ANSWERS, given by time_, end_, total_ and count_
+     * kProblemStats: a problem of QUERY_PROBLEM_STATS, given by problem_, accepted_count_ (solved), total_ (attempts), count_ (frozen attempts), and team_ and time_ of the first solver. team_ is nullptr if the problem has not been solved
+     * kEnd: the end of the records, only used to stop the pipeline
+     */
+    enum Type : unsigned char {
+        kMessage, kRanking, kSubmission, kScrollChange, kRow, kHistoryRanking, kHistorySubmission, kProblemAnalysis, kBucketAnalysis, kProblemStats, kEnd
+    };
+
+    enum Message : unsigned char {
+        kAddSuccessfully, kAddFailedStarted, kAddFailedDuplicated, kStartSuccessfully, kStartFailed,
+        kFlushSuccessfully, kFreezeSuccessfully, kFreezeFailed, kScrollSuccessfully, kScrollFailed,
+        kQueryRankingFailed, kQuerySubmissionFailed, kEndSuccessfully, kQueryTopSuccessfully, kFrozenWarning,
+        kPrintRangeSuccessfully, kPrintRangeFailed, kPrintHistorySuccessfully, kQueryHistoryRankingFailed,
+        kQueryHistorySuccessfully, kQueryHistoryFailed, kNoSubmission, kAnalyzeProblemsSuccessfully,
+        kAnalyzeWrongAnswersSuccessfully, kAnalyzeWrongAnswersFailed, kQueryProblemStatsSuccessfully,
+        kQueryHistoryRankingFailedNotStarted, kPrintHistoryFailedNotStarted, kQueryHistoryFailedNotStarted,
+        kMessageCount
+    };
+
+    constexpr static const char *const kMessageString[kMessageCount] = {
+            "[Info]Add successfully.", "[Error]Add failed: competition has started.",
+            "[Error]Add failed: duplicated team name.", "[Info]Competition starts.",
+            "[Error]Start failed: competition has started.", "[Info]Flush scoreboard.", "[Info]Freeze scoreboard.",
+            "[Error]Freeze failed: scoreboard has been frozen.", "[Info]Scroll scoreboard.",
+            "[Error]Scroll failed: scoreboard has not been frozen.",
+            "[Error]Query ranking failed: cannot find the team.",
+            "[Error]Query submission failed: cannot find the team.", "[Info]Competition ends.",
+            "[Info]Complete query top.",
+            "[Warning]Scoreboard is frozen. The ranking may be inaccurate until it were scrolled.",
+            "[Info]Complete print range.", "[Error]Print range failed: invalid range.",
+            "[Info]Complete print history.", "[Error]Query history ranking failed: cannot find the team.",
+            "[Info]Complete query history.", "[Error]Query history failed: cannot find the team.",
+            "Cannot find any submission.", "[Info]Complete analyze problems.",
+            "[Info]Complete analyze wrong answers.", "[Error]Analyze wrong answers failed: invalid bucket width.",
+            "[Info]Complete query problem stats.",
+            "[Error]Query history ranking failed: competition has not started.",
+            "[Error]Print history failed: competition has not started.",
+            "[Error]Query history failed: competition has not started."
+    }; // the lines of the messages
+
+    Type type_ = kEnd;
+    unsigned char message_ = 0;
+    bool frozen_ = false;
+    unsigned char problem_count_ = 0;
+    const Team *team_ = nullptr;
+    const Team *replaced_team_ = nullptr;
+    int rank_ = 0;
+    int accepted_count_ = 0;
+    int penalty_ = 0;
+    int problem_ = 0;
+    int result_ = 0;
+    int time_ = 0;
+    int end_ = 0;
+    int total_ = 0;
+    int count_ = 0;
+    unsigned long long cells_[kMaxProblemCount] = {}; // the problem cells of a row, encoded by Team::getCell
+};
+
+struct ICPCManagementSystem::Submission {
+    Team *team_;
+    int problem_;
+    int result_;
+    int time_;
+
+    Submission() : team_(nullptr), problem_(0), result_(0), time_(0) {}
+
+    Submission(Team *team, int problem, int result, int time) : team_(team), problem_(problem), result_(result),
+                                                                time_(time) {}
+
+    /**
+     * @brief Check whether the submission exists
+     * @details Check whether the submission exists, by checking whether the team pointer is nullptr
+     *
+     * @return true if the submission exists, false otherwise
+     */
+    inline bool exists() const {
+        return team_ != nullptr;
+    }
+
+    /**
+     * @brief Store a submission into a submission slot which may be read concurrently
+     * @details Store each field with a relaxed atomic store, the consistency is guaranteed by the seqlock of the team
+     */
+    inline void storeRelaxed(const Submission &submission) {
+        __atomic_store_n(&team_, submission.team_, __ATOMIC_RELAXED);
+        __atomic_store_n(&problem_, submission.problem_, __ATOMIC_RELAXED);
+        __atomic_store_n(&result_, submission.result_, __ATOMIC_RELAXED);
+        __atomic_store_n(&time_, submission.time_, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * @brief Load a submission from a submission slot which may be written concurrently
+     * @details Load each field with a relaxed atomic load, the consistency is guaranteed by the seqlock of the team
+     */
+    inline Submission loadRelaxed() const {
+        return {__atomic_load_n(&team_, __ATOMIC_RELAXED), __atomic_load_n(&problem_, __ATOMIC_RELAXED),
+                __atomic_load_n(&result_, __ATOMIC_RELAXED), __atomic_load_n(&time_, __ATOMIC_RELAXED)};
+    }
+};
+
+struct alignas(64) ICPCManagementSystem::TeamRanking {
+    int accepted_count_ = 0;
+    int penalty_ = 0;
+    int accepted_time_[kMaxProblemCount] = {};
+};
+
+struct ICPCManagementSystem::Team {
+    TeamName name_;
+    int accepted_problems_;
+    int frozen_problems_;
+    int rank_;
+    int published_rank_ = 0; // the rank in the previous publish of the delta stream, 0 before the first one
+    bool dirty_ = false; // whether a cell of the team has changed since the previous publish of the delta stream, by flushing, a frozen submission or scrolling
+    unsigned long long published_digest_ = 0; // the digest of the row in the previous publish of the delta stream
+    int batch_head_ = -1; // the first record of the team in the current batch of submitBatch, -1 if none
+    int batch_tail_ = -1; // the last record of the team in the current batch of submitBatch
+
+    /**
+     * @brief The struct of problem
+     * @details The struct of problem, including the number of unaccepted submissions, the accepted time, the number of submissions after the scoreboard is frozen, the number of unaccepted submissions after the scoreboard is frozen and the accepted time after the scoreboard is frozen
+     *
+     * @param unaccepted_submissions_ The number of unaccepted submissions before the problem is accepted, updated when flushing or scrolling
+     * @param accepted_time_ The time when the problem is accepted, updated when flushing or scrolling
+     * @param submissions_after_frozen_ The number of submissions after the scoreboard is frozen, updated when submitting. It will be reset to 0 when the scoreboard is scrolled
+     * @param unaccepted_submissions_after_frozen_ The number of unaccepted submissions after the scoreboard is frozen, and before the problem is accepted. It will be added to unaccepted_submissions_ and reset to 0 when the scoreboard is scrolled
+     * @param accepted_time_after_frozen_ The accepted time after the scoreboard is frozen. It will be used to update accepted_time_ when the problem is accepted when the scoreboard is scrolled
+     */
+    struct Problem {
+        int unaccepted_submissions_;
+        int accepted_time_;
+        int submissions_after_frozen_;
+        int unaccepted_submissions_after_frozen_;
+        int accepted_time_after_frozen_;
+
+        Problem() : unaccepted_submissions_(0), accepted_time_(0), submissions_after_frozen_(0),
+                    unaccepted_submissions_after_frozen_(0), accepted_time_after_frozen_(0) {}
+
+        /**
+         * @brief Get the penalty
+         * @details Get the penalty. The penalty is the number of unaccepted submissions * 20 + the accepted time
+         * @return
+         */
+        inline int getPenalty() const {
+            return unaccepted_submissions_ * 20 + accepted_time_;
+        }
+
+        /**
+         * @brief Unfreeze the problem
+         * @details Unfreeze the problem, including updating the accepted time, the number of unaccepted submissions and resetting the number of submissions after the scoreboard is frozen, the number of unaccepted submissions after the scoreboard is frozen and the accepted time after the scoreboard is frozen
+         */
+        inline void unfreeze() {
+            unaccepted_submissions_ += unaccepted_submissions_after_frozen_;
+            accepted_time_ = accepted_time_after_frozen_;
+            submissions_after_frozen_ = 0;
+            unaccepted_submissions_after_frozen_ = 0;
+            accepted_time_after_frozen_ = 0;
+        }
+
+        /**
+         * @brief Check whether the problem has been accepted
+         * @details Check whether the problem has been accepted, by checking whether the accepted time is 0
+         * if the accepted time is 0, the problem has not been accepted
+         * if the accepted time is not 0, the problem has been accepted
+         *
+         * @return true if the problem has been accepted, false otherwise
+         */
+        inline bool accepted() const {
+            return accepted_time_ != 0;
+        }
+    };
+
+    Problem *problems_;
+    Submission *last_submission_[kStatusCount + 1]{};
+    TeamRanking *ranking_;
+    SubmissionList submission_list_; // all the submissions of the team
+    std::atomic<unsigned int> sequence_{0}; // the sequence of the seqlock protecting last_submission_, odd while being written
+
+    /**
+     * @brief Read a submission slot under the seqlock
+     * @details Retry until the slot is not written during the read, so the readers never block the writer
+     * @param result the result id, kStatusCount for ALL
+     * @param problem_id the problem id, problems for ALL
+     * @return The submission in the slot
+     */
+    Submission readSubmission(int result, int problem_id) const {
+        while (true) {
+            unsigned int sequence = sequence_.load(std::memory_order_acquire);
+            if (sequence & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            Submission submission = last_submission_[result][problem_id].loadRelaxed();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == sequence) {
+                return submission;
+            }
+        }
+    }
+
+    Team() : accepted_problems_(0), frozen_problems_(0), rank_(0), problems_(nullptr), ranking_(nullptr) {}
+
+    /**
+     * @brief Get the size of the per-team arrays of all the teams
+     * @param teams the number of teams
+     * @param problems the number of problems
+     * @return The size of the arena in bytes
+     */
+    static size_t getArenaSize(int teams, int problems) {
+        return static_cast<size_t>(teams) * ((kStatusCount + 1) * (problems + 1) * sizeof(Submission) +
+                                             problems * (sizeof(Problem) + kStatusCount * sizeof(int)));
+    }
+
+    /**
+     * @brief Initialize the team
+     * @details Initialize the team, with the per-team arrays carved from the arena. The arena is laid out as the last_submission_ arrays of all the teams, then the problems_ arrays, then the heads of the submission lists.
+     * Different teams touch different parts of the arena, so they can be initialized by different threads.
+     *
+     * @param name the name of the team
+     * @param problems the number of problems
+     * @param rank the initial rank of the team
+     * @param arena the arena of getArenaSize(teams, problems) bytes
+     * @param teams the number of teams
+     * @param id the position of the team in the arena
+     * @param ranking the ranking record of the team
+     */
+    void initialize(std::string_view name, int problems, int rank, void *arena, int teams, int id,
+                    TeamRanking *ranking) {
+        name_.assign(name);
+        accepted_problems_ = 0;
+        frozen_problems_ = 0;
+        rank_ = rank;
+        ranking_ = ranking;
+        ranking_->accepted_count_ = 0;
+        ranking_->penalty_ = 0;
+        auto *submissions = static_cast<Submission *>(arena);
+        auto *problem_arena = reinterpret_cast<Problem *>(
+                submissions + static_cast<size_t>(teams) * (kStatusCount + 1) * (problems + 1));
+        for (int i = 0; i <= kStatusCount; ++i) {
+            last_submission_[i] = submissions + (static_cast<size_t>(id) * (kStatusCount + 1) + i) * (problems + 1);
+            for (int j = 0; j <= problems; ++j) {
+                new(last_submission_[i] + j) Submission();
+            }
+        }
+        problems_ = problem_arena + static_cast<size_t>(id) * problems;
+        for (int i = 0; i < problems; ++i) {
+            new(problems_ + i) Problem();
+        }
+        auto *head_arena = reinterpret_cast<int *>(problem_arena + static_cast<size_t>(teams) * problems);
+        submission_list_.initialize(problems, head_arena + static_cast<size_t>(id) * kStatusCount * problems);
+    }
+
+    /**
+     * @brief Check whether the team has frozen problems
+     * @details Check whether the team has frozen problems, by checking whether the frozen_problems_ is not 0
+     * @param problem_id the problem id
+     * @return true if the team has frozen problems, false otherwise
+     */
+    inline bool isFrozen(int problem_id) const {
+        return frozen_problems_ & (1 << problem_id);
+    }
+
+    /**
+     * @brief Get the first frozen problem
+     * @details Get the first frozen problem, by using __builtin_ctz
+     * @return The first frozen problem
+     */
+    inline int getFirstFrozenProblem() const {
+        return __builtin_ctz(frozen_problems_);
+    }
+
+    /**
+     * @brief Get the number of accepted problems
+     * @details Get the number of accepted problems, by using __builtin_popcount
+     * @return The number of accepted problems
+     */
+    inline int getAcceptedCount() const {
+        return __builtin_popcount(accepted_problems_);
+    }
+
+    /**
+     * @brief Get the penalty, kept in the ranking record
+     */
+    inline int getPenalty() const {
+        return ranking_->penalty_;
+    }
+
+    static const int kCellUntried = 0; // the cell of a problem which has not been accepted, and is not frozen
+    static const int kCellAccepted = 1; // the cell of a problem which has been accepted, and is not frozen
+    static const int kCellFrozen = 2; // the cell of a frozen problem
+
+    /**
+     * @brief Get the cell of a problem on the scoreboard
+     * @details Encode the state of the cell in the lowest 2 bits, the number of unaccepted submissions in the next 31 bits, and the number of submissions after the scoreboard is frozen in the highest 31 bits
+     * @param problem_id the problem id
+     * @return The encoded cell
+     */
+    inline unsigned long long getCell(int problem_id) const {
+        const Problem &problem = problems_[problem_id];
+        unsigned long long cell = static_cast<unsigned long long>(problem.unaccepted_submissions_) << 2;
+        if (isFrozen(problem_id)) {
+            return cell | kCellFrozen | static_cast<unsigned long long>(problem.submissions_after_frozen_) << 33;
+        }
+        return cell | (problem.accepted() ? kCellAccepted : kCellUntried);
+    }
+
+    /**
+     * @brief Get the digest of the row on the scoreboard
+     * @details Hash the solved count, the penalty and the cells, used to find the changed rows for the delta stream
+     * @param problems the number of problems
+     * @return The digest
+     */
+    unsigned long long getDigest(int problems) const {
+        unsigned long long digest = static_cast<unsigned long long>(accepted_problems_) << 32 | static_cast<unsigned int>(getPenalty());
+        for (int problem_id = 0; problem_id < problems; ++problem_id) {
+            digest = (digest ^ getCell(problem_id)) * 0x100000001b3ULL;
+        }
+        return digest;
+    }
+
+    /**
+     * @brief Set the accepted time
+     * @details Set the accepted count and the accepted_time_ array of the ranking record, and sort it in descending order
+     */
+    void setAcceptTime() const {
+        int mask = accepted_problems_, i = 0;
+        int *accepted_time = ranking_->accepted_time_;
+        while (mask) {
+            int problem_id = __builtin_ctz(mask);
+            accepted_time[i] = problems_[problem_id].accepted_time_;
+            mask ^= 1 << problem_id;
+            ++i;
+        }
+        std::sort(accepted_time, accepted_time + i, std::greater<>());
+        ranking_->accepted_count_ = i;
+    }
+};
+
+inline ICPCManagementSystem::Team *ICPCManagementSystem::getTeam(const TeamRanking *ranking) const {
+    return teams_ + (ranking - team_rankings_);
+}
+
+// the hot calls are inline, so a judge daemon linking the library calls them without a function call;
+// they take amortized O(1) time, but allocate when the submission lists and the history grow, and the history copies a checkpoint every max(T * P, 4096) submissions
+
+inline void ICPCManagementSystem::applySubmission(Team *team, int problem_id, int result, int time) {
+    if (frozen_) {
+        // update the problem data of the team
+        Team::Problem &problem = team->problems_[problem_id];
+        ++problem.submissions_after_frozen_;
+        // If the problem has been accepted, do nothing
+        if (!team->last_submission_[0][problem_id].exists()) {
+            team->frozen_problems_ |= 1 << problem_id;
+            if (result == 0) {
+                // Accepted
+                problem.accepted_time_after_frozen_ = time;
+            } else {
+                // Unaccepted
+                ++problem.unaccepted_submissions_after_frozen_;
+            }
+        }
+        if (team->isFrozen(problem_id)) {
+            // the frozen cell shows the submission at once, while the other cells change when flushing
+            team->dirty_ = true;
+            ++problem_stats_[problem_id].frozen_attempts_;
+            if (scroll_planner_ != nullptr) {
+                precomputeSubmission(team, problem_id);
+            }
+        }
+    }
+    team->submission_list_.append(problem_id, result, time);
+}
+
+inline void ICPCManagementSystem::storeLastSubmission(const Submission &submission) {
+    Team *team = submission.team_;
+    team->last_submission_[submission.result_][submission.problem_].storeRelaxed(submission);
+    team->last_submission_[submission.result_][problems_].storeRelaxed(submission);
+    team->last_submission_[kStatusCount][submission.problem_].storeRelaxed(submission);
+    team->last_submission_[kStatusCount][problems_].storeRelaxed(submission);
+}
+
+inline void ICPCManagementSystem::submitSolution(std::string_view team_name, int problem_id, int result, int time) {
+    Team *team = getTeamPointer(team_name);
+    Submission submission(team, problem_id, result, time);
+    if (!frozen_) {
+        // push the submission into the submission list, waiting for flushing
+        submissions_.push_back(submission);
+    }
+    applySubmission(team, problem_id, result, time);
+    history_.append(static_cast<int>(team - teams_), problem_id, result, time);
+    // update the last submission data of the team under its seqlock, for the concurrent readers
+    unsigned int sequence = team->sequence_.load(std::memory_order_relaxed);
+    team->sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    storeLastSubmission(submission);
+    team->sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+inline int ICPCManagementSystem::queryRanking(std::string_view team_name) {
+    Team *team = getTeamPointer(team_name);
+    if (team == nullptr) {
+        putMessage(*sink_, Result::kQueryRankingFailed);
+        return -1;
+    }
+    putRanking(*sink_, team, team->rank_, frozen_);
+    return team->rank_;
+}
+
+inline bool ICPCManagementSystem::querySubmission(std::string_view team_name, int problem_id, int result) {
+    Team *team = getTeamPointer(team_name);
+    if (team == nullptr) {
+        putMessage(*sink_, Result::kQuerySubmissionFailed);
+        return false;
+    }
+    putSubmission(*sink_, team, team->last_submission_[result][problem_id]);
+    return true;
+}
+
+#endif //ACM_ICPC_MANAGEMENT_ICPC_MANAGEMENT_SYSTEM_H
@@ -0,0 +1,94 @@
+#ifndef ACM_ICPC_MANAGEMENT_KEYWORD_TABLE_H
+#define ACM_ICPC_MANAGEMENT_KEYWORD_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief The class of keyword table
+ * @details The class of keyword table, a perfect hash table over a fixed vocabulary, built at compile time.
+ * The hash of a word only reads its length, its first character and its last character, and a multiplier is searched at compile time so that no two keywords share a slot. A lookup is one multiplication and at most one comparison.
+ *
+ * @tparam kCount the number of keywords
+ * @tparam kBits the number of slots is 2 ^ kBits
+ */
+template<size_t kCount, int kBits = 6>
+class KeywordTable {
+public:
+    /**
+     * @brief Build the table
+     * @details Try the odd multipliers in order until all the keywords fall into different slots. If none is found, found() is false, which is checked by a static_assert where the table is defined.
+     *
+     * @param entries the array of entries, whose index is the value of the keyword
+     * @param keyword the function getting the keyword of an entry
+     */
+    template<typename Entry, typename Keyword>
+    constexpr KeywordTable(const Entry (&entries)[kCount], Keyword keyword) : keywords_(), slots_(), multiplier_(0) {
+        for (size_t i = 0; i < kCount; ++i) {
+            keywords_[i] = keyword(entries[i]);
+        }
+        for (uint32_t multiplier = 1; multiplier < kMaxMultiplier; multiplier += 2) {
+            for (int &slot: slots_) {
+                slot = -1;
+            }
+            bool collided = false;
+            for (size_t i = 0; i < kCount && !collided; ++i) {
+                int &slot = slots_[getSlot(keywords_[i], multiplier)];
+                collided = slot >= 0;
+                slot = static_cast<int>(i);
+            }
+            if (!collided) {
+                multiplier_ = multiplier;
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Check whether a collision-free multiplier is found
+     */
+    constexpr bool found() const {
+        return multiplier_ != 0;
+    }
+
+    /**
+     * @brief Find a word
+     * @param word the word
+     * @return The index of the keyword, -1 if the word is not a keyword
+     */
+    constexpr int find(std::string_view word) const {
+        int index = slots_[getSlot(word, multiplier_)];
+        return index >= 0 && keywords_[index] == word ? index : -1;
+    }
+
+    /**
+     * @brief Find a word which is known to be a keyword
+     * @details The word is not compared, so a word out of the vocabulary gets an arbitrary index or -1
+     * @param word the word
+     * @return The index of the keyword
+     */
+    constexpr int findKnown(std::string_view word) const {
+        return slots_[getSlot(word, multiplier_)];
+    }
+
+private:
+    static constexpr size_t kSize = size_t(1) << kBits; // the number of slots
+    static constexpr uint32_t kMaxMultiplier = 1u << 16; // the bound of the multipliers to try
+
+    std::string_view keywords_[kCount]; // the keywords
+    int slots_[kSize]; // the index of the keyword in each slot, -1 for empty
+    uint32_t multiplier_; // the multiplier of the hash, 0 if not found
+
+    static constexpr size_t getSlot(std::string_view word, uint32_t multiplier) {
+        if (word.empty()) {
+            return 0;
+        }
+        uint32_t key = static_cast<uint32_t>(static_cast<unsigned char>(word.front())) |
+                       static_cast<uint32_t>(static_cast<unsigned char>(word.back())) << 8 |
+                       static_cast<uint32_t>(word.size()) << 16;
+        return static_cast<uint32_t>(key * multiplier) >> (32 - kBits);
+    }
+};
+
+#endif //ACM_ICPC_MANAGEMENT_KEYWORD_TABLE_H
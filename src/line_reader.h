@@ -0,0 +1,101 @@
+#ifndef ACM_ICPC_MANAGEMENT_LINE_READER_H
+#define ACM_ICPC_MANAGEMENT_LINE_READER_H
+
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+
+/**
+ * @brief The class of line reader
+ * @details The class of line reader, which reads a file descriptor in large chunks and splits them into lines in place, so a line costs no copy and no system call.
+ * The last line is returned even if it has no line break. A line longer than the chunk is skipped up to its line break, and reported once to stderr.
+ */
+class LineReader {
+public:
+    /**
+     * @brief Construct a new LineReader object
+     * @param fd the file descriptor to read from
+     */
+    explicit LineReader(int fd) : fd_(fd), data_(new char[kChunkSize + 1]), begin_(0), end_(0), end_of_input_(false), skipping_(false) {}
+
+    LineReader(const LineReader &) = delete;
+
+    LineReader &operator=(const LineReader &) = delete;
+
+    ~LineReader() {
+        delete[] data_;
+    }
+
+    /**
+     * @brief Read the next line
+     * @return The line without the line break, which is valid until the next call, nullptr at the end of the input
+     */
+    char *readLine() {
+        while (true) {
+            char *line = data_ + begin_;
+            auto *line_break = static_cast<char *>(memchr(line, '\n', end_ - begin_));
+            if (line_break != nullptr) {
+                begin_ = line_break + 1 - data_;
+                if (skipping_) {
+                    reportLongLine();
+                    continue;
+                }
+                *line_break = '\0';
+                return line;
+            }
+            if (end_of_input_) {
+                if (skipping_) {
+                    begin_ = end_;
+                    reportLongLine();
+                }
+                if (begin_ == end_) {
+                    return nullptr;
+                }
+                data_[end_] = '\0';
+                begin_ = end_;
+                return line;
+            }
+            // move the incomplete line to the front, and read after it
+            // a line filling the whole chunk is skipped, so that its tail is not read as another line
+            size_t size = end_ - begin_;
+            if (size == kChunkSize || skipping_) {
+                skipping_ = true;
+                size = 0;
+            }
+            memmove(data_, line, size);
+            begin_ = 0;
+            end_ = size;
+            ssize_t ret = read(fd_, data_ + end_, kChunkSize - end_);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                end_of_input_ = true;
+            } else {
+                end_ += ret;
+            }
+        }
+    }
+
+private:
+    /**
+     * @brief Report the skipped line and leave the skipping state
+     */
+    void reportLongLine() {
+        skipping_ = false;
+        fprintf(stderr, "line longer than %zu bytes is skipped\n", kChunkSize);
+    }
+
+    static const size_t kChunkSize = 1 << 20; // the size of one read
+
+    int fd_; // the file descriptor to read from
+    char *data_; // the buffer of kChunkSize bytes and a byte for the '\0' after the last line
+    size_t begin_; // the beginning of the unread data
+    size_t end_; // the end of the read data
+    bool end_of_input_; // whether the end of the input is reached
+    bool skipping_; // whether the rest of a line longer than the chunk is being skipped
+};
+
+#endif //ACM_ICPC_MANAGEMENT_LINE_READER_H
@@ -0,0 +1,347 @@
+//
+// Load generating client of the socket server mode.
+//
+// It sets up a contest with the given number of teams, then opens several connections which send a mix of
+// SUBMIT and QUERY commands concurrently, and reports the throughput and the latency of the queries.
+//
+// usage: ICPC_load_client (--socket PATH | --port PORT) [--clients C] [--teams N] [--problems M]
+//                         [--requests R] [--read-ratio K] [--flush-every F] [--no-setup] [--end]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/**
+ * @brief The struct of options
+ *
+ * @param socket_path_ The path of the Unix domain socket, nullptr if connecting to a TCP port
+ * @param port_ The loopback TCP port
+ * @param clients_ The number of concurrent connections
+ * @param teams_ The number of teams
+ * @param problems_ The number of problems
+ * @param requests_ The number of requests sent by each connection
+ * @param read_ratio_ The number of queries sent for each submission
+ * @param flush_every_ The number of submissions of a connection between two FLUSH, 0 for never
+ * @param setup_ Whether to add the teams and start the contest
+ * @param end_ Whether to send END after all the connections finish
+ */
+struct Options {
+    const char *socket_path_ = nullptr;
+    int port_ = -1;
+    int clients_ = 4;
+    int teams_ = 1000;
+    int problems_ = 26;
+    int requests_ = 100000;
+    int read_ratio_ = 20;
+    int flush_every_ = 1000;
+    bool setup_ = true;
+    bool end_ = false;
+};
+
+/**
+ * @brief The class of connection
+ * @details The class of connection to the server, which sends the commands with a buffer and reads the replies line by line
+ */
+class Connection {
+public:
+    explicit Connection(const Options &options) : fd_(-1), begin_(0), end_(0) {
+        if (options.socket_path_ != nullptr) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, options.socket_path_, sizeof(address.sun_path) - 1);
+            fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (connect(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+                close(fd_);
+                fd_ = -1;
+            }
+        } else {
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_port = htons(options.port_);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            fd_ = socket(AF_INET, SOCK_STREAM, 0);
+            int no_delay = 1;
+            setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+            if (connect(fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+                close(fd_);
+                fd_ = -1;
+            }
+        }
+    }
+
+    ~Connection() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+
+    bool connected() const {
+        return fd_ >= 0;
+    }
+
+    /**
+     * @brief Queue a command, which is sent at the next send()
+     */
+    void queue(const char *command) {
+        pending_ += command;
+        pending_ += '\n';
+    }
+
+    /**
+     * @brief Send all the queued commands
+     * @return true if succeeded, false otherwise
+     */
+    bool send() {
+        size_t written = 0;
+        while (written < pending_.size()) {
+            ssize_t ret = ::send(fd_, pending_.data() + written, pending_.size() - written, MSG_NOSIGNAL);
+            if (ret <= 0) {
+                if (ret < 0 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            written += ret;
+        }
+        pending_.clear();
+        return true;
+    }
+
+    /**
+     * @brief Read a line of reply, without the line break
+     * @return true if succeeded, false if the connection is closed
+     */
+    bool readLine(std::string &line) {
+        line.clear();
+        while (true) {
+            for (size_t i = begin_; i < end_; ++i) {
+                if (buffer_[i] == '\n') {
+                    line.append(buffer_ + begin_, i - begin_);
+                    begin_ = i + 1;
+                    return true;
+                }
+            }
+            line.append(buffer_ + begin_, end_ - begin_);
+            begin_ = end_ = 0;
+            ssize_t ret = read(fd_, buffer_, sizeof(buffer_));
+            if (ret <= 0) {
+                if (ret < 0 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            end_ = ret;
+        }
+    }
+
+private:
+    int fd_; // the file descriptor of the connection
+    std::string pending_; // the queued commands
+    char buffer_[1 << 16]{}; // the buffer of replies
+    size_t begin_; // the beginning of the unread replies in buffer_
+    size_t end_; // the end of the unread replies in buffer_
+};
+
+/**
+ * @brief The struct of the statistics of a connection
+ *
+ * @param requests_ The number of requests sent
+ * @param latencies_ The latencies of the queries, in microseconds
+ */
+struct Statistics {
+    long long requests_ = 0;
+    std::vector<double> latencies_;
+};
+
+static std::string teamName(int team_id) {
+    char name[16];
+    snprintf(name, sizeof(name), "team%05d", team_id);
+    return name;
+}
+
+/**
+ * @brief Read the reply of a query
+ * @details The reply of a query is one line of error, or one line of information, an optional line of warning and one line of result
+ */
+static bool readQueryReply(Connection &connection, std::string &line) {
+    if (!connection.readLine(line)) {
+        return false;
+    }
+    if (line.compare(0, 7, "[Error]") == 0) {
+        return true;
+    }
+    if (!connection.readLine(line)) {
+        return false;
+    }
+    if (line.compare(0, 9, "[Warning]") == 0) {
+        return connection.readLine(line);
+    }
+    return true;
+}
+
+/**
+ * @brief Send the requests of one connection
+ * @details The submissions are sent without waiting, since they have no reply. Each query is sent with the commands before it, and the latency is measured until its reply is read.
+ */
+static void runClient(const Options &options, int client_id, std::atomic<int> &clock, Statistics &statistics) {
+    static const char *const kStatus[] = {"Accepted", "Wrong_Answer", "Runtime_Error", "Time_Limit_Exceed"};
+    Connection connection(options);
+    if (!connection.connected()) {
+        fprintf(stderr, "client %d: cannot connect\n", client_id);
+        return;
+    }
+    std::mt19937 random(client_id + 1);
+    std::string line;
+    char command[128];
+    int submissions = 0, pending_flushes = 0;
+    for (int i = 0; i < options.requests_; ++i) {
+        if (random() % (options.read_ratio_ + 1) == 0) {
+            // a submission, the submission time is shared by all the connections so that it is non-decreasing
+            int time = 1 + clock.fetch_add(1, std::memory_order_relaxed) / 100;
+            snprintf(command, sizeof(command), "SUBMIT %c BY %s WITH %s AT %d",
+                     static_cast<char>('A' + random() % options.problems_),
+                     teamName(static_cast<int>(random() % options.teams_)).c_str(), kStatus[random() % 4], time);
+            connection.queue(command);
+            if (options.flush_every_ > 0 && ++submissions % options.flush_every_ == 0) {
+                connection.queue("FLUSH");
+                ++pending_flushes;
+            }
+        } else {
+            std::string team_name = teamName(static_cast<int>(random() % options.teams_));
+            if (random() % 2) {
+                snprintf(command, sizeof(command), "QUERY_RANKING %s", team_name.c_str());
+            } else {
+                snprintf(command, sizeof(command), "QUERY_SUBMISSION %s WHERE PROBLEM=ALL AND STATUS=ALL",
+                         team_name.c_str());
+            }
+            connection.queue(command);
+            auto begin = std::chrono::steady_clock::now();
+            if (!connection.send()) {
+                fprintf(stderr, "client %d: connection closed\n", client_id);
+                return;
+            }
+            for (; pending_flushes > 0; --pending_flushes) {
+                connection.readLine(line);
+            }
+            if (!readQueryReply(connection, line)) {
+                fprintf(stderr, "client %d: connection closed\n", client_id);
+                return;
+            }
+            auto end = std::chrono::steady_clock::now();
+            statistics.latencies_.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+        }
+        ++statistics.requests_;
+    }
+    connection.send();
+    for (; pending_flushes > 0; --pending_flushes) {
+        connection.readLine(line);
+    }
+}
+
+static bool parseOptions(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if (strcmp(argument, "--socket") == 0 && has_value) {
+            options.socket_path_ = argv[++i];
+        } else if (strcmp(argument, "--port") == 0 && has_value) {
+            options.port_ = atoi(argv[++i]);
+        } else if (strcmp(argument, "--clients") == 0 && has_value) {
+            options.clients_ = atoi(argv[++i]);
+        } else if (strcmp(argument, "--teams") == 0 && has_value) {
+            options.teams_ = atoi(argv[++i]);
+        } else if (strcmp(argument, "--problems") == 0 && has_value) {
+            options.problems_ = atoi(argv[++i]);
+        } else if (strcmp(argument, "--requests") == 0 && has_value) {
+            options.requests_ = atoi(argv[++i]);
+        } else if (strcmp(argument, "--read-ratio") == 0 && has_value) {
+            options.read_ratio_ = atoi(argv[++i]);
+        } else if (strcmp(argument, "--flush-every") == 0 && has_value) {
+            options.flush_every_ = atoi(argv[++i]);
+        } else if (strcmp(argument, "--no-setup") == 0) {
+            options.setup_ = false;
+        } else if (strcmp(argument, "--end") == 0) {
+            options.end_ = true;
+        } else {
+            return false;
+        }
+    }
+    return (options.socket_path_ != nullptr || options.port_ >= 0) && options.clients_ > 0 &&
+           options.teams_ > 0 && options.problems_ > 0 && options.problems_ <= 26 && options.read_ratio_ >= 0;
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage: %s (--socket PATH | --port PORT) [--clients C] [--teams N] [--problems M] "
+                        "[--requests R] [--read-ratio K] [--flush-every F] [--no-setup] [--end]\n", argv[0]);
+        return 1;
+    }
+    Connection control(options);
+    if (!control.connected()) {
+        fprintf(stderr, "cannot connect to the server\n");
+        return 1;
+    }
+    std::string line;
+    if (options.setup_) {
+        for (int i = 0; i < options.teams_; ++i) {
+            control.queue(("ADDTEAM " + teamName(i)).c_str());
+        }
+        control.queue(("START DURATION 100000 PROBLEM " + std::to_string(options.problems_)).c_str());
+        control.send();
+        for (int i = 0; i <= options.teams_; ++i) {
+            control.readLine(line);
+        }
+    }
+
+    std::atomic<int> clock(0);
+    std::vector<Statistics> statistics(options.clients_);
+    std::vector<std::thread> clients;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.clients_; ++i) {
+        clients.emplace_back(runClient, std::cref(options), i, std::ref(clock), std::ref(statistics[i]));
+    }
+    for (auto &client: clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    long long requests = 0;
+    std::vector<double> latencies;
+    for (auto &item: statistics) {
+        requests += item.requests_;
+        latencies.insert(latencies.end(), item.latencies_.begin(), item.latencies_.end());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    printf("clients %d, requests %lld, %.3f s, %.0f requests/s\n", options.clients_, requests, seconds,
+           requests / seconds);
+    if (!latencies.empty()) {
+        auto percentile = [&latencies](double p) {
+            return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+        };
+        printf("query latency (us): p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", percentile(0.5), percentile(0.9),
+               percentile(0.99), latencies.back());
+    }
+
+    if (options.end_) {
+        control.queue("END");
+        control.send();
+        control.readLine(line);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#ifndef ACM_ICPC_MANAGEMENT_MAPPED_INPUT_H
+#define ACM_ICPC_MANAGEMENT_MAPPED_INPUT_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief The class of mapped input
+ * @details The class of mapped input, which maps a whole command log into memory and hands out the lines in place, so replaying a log costs no read and no copy.
+ * A line is returned as a pointer into the mapping, ended by its line break, which the parser treats as the end of the line.
+ * The last line without a line break is copied out, since the bytes after it may be beyond the mapping.
+ */
+class MappedInput {
+public:
+    /**
+     * @brief Construct a new MappedInput object
+     * @details Map the file read-only, and advise the kernel that it is read sequentially so that it reads ahead aggressively and drops the pages behind
+     * @param path the path of the file
+     */
+    explicit MappedInput(const char *path) : opened_(false), data_(nullptr), size_(0), begin_(0), end_(0),
+                                             tail_read_(false) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat status{};
+        if (fstat(fd, &status) == 0) {
+            opened_ = true;
+            if (status.st_size > 0) {
+                void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED) {
+                    opened_ = false;
+                } else {
+                    data_ = static_cast<const char *>(data);
+                    size_ = status.st_size;
+                    madvise(data, size_, MADV_SEQUENTIAL);
+                }
+            }
+        }
+        close(fd);
+        end_ = size_;
+        if (end_ > 0 && data_[end_ - 1] != '\n') {
+            // the last line has no line break
+            const auto *line_break = static_cast<const char *>(memrchr(data_, '\n', end_));
+            size_t tail = line_break == nullptr ? 0 : line_break + 1 - data_;
+            tail_.assign(data_ + tail, end_ - tail);
+            end_ = tail;
+        }
+    }
+
+    MappedInput(const MappedInput &) = delete;
+
+    MappedInput &operator=(const MappedInput &) = delete;
+
+    ~MappedInput() {
+        if (data_ != nullptr) {
+            munmap(const_cast<char *>(data_), size_);
+        }
+    }
+
+    /**
+     * @brief Check whether the file is mapped
+     */
+    bool opened() const {
+        return opened_;
+    }
+
+    /**
+     * @brief Read the next line
+     * @return The line, ended by a line break or '\0', which is valid until the object is destroyed, nullptr at the end of the input
+     */
+    const char *readLine() {
+        if (begin_ < end_) {
+            const char *line = data_ + begin_;
+            const auto *line_break = static_cast<const char *>(memchr(line, '\n', end_ - begin_));
+            begin_ = line_break + 1 - data_;
+            return line;
+        }
+        if (!tail_read_ && !tail_.empty()) {
+            tail_read_ = true;
+            return tail_.c_str();
+        }
+        return nullptr;
+    }
+
+private:
+    bool opened_; // whether the file is mapped
+    const char *data_; // the mapping, nullptr if the file is empty
+    size_t size_; // the size of the mapping
+    size_t begin_; // the beginning of the unread lines
+    size_t end_; // the end of the lines ended by a line break
+    std::string tail_; // the last line without a line break
+    bool tail_read_; // whether tail_ has been returned
+};
+
+#endif //ACM_ICPC_MANAGEMENT_MAPPED_INPUT_H
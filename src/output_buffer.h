@@ -0,0 +1,202 @@
+#ifndef ACM_ICPC_MANAGEMENT_OUTPUT_BUFFER_H
+#define ACM_ICPC_MANAGEMENT_OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <unistd.h>
+
+/**
+ * @brief The interface taking the filled data of an output buffer bound to a file descriptor, instead of writing it with write(2)
+ */
+class OutputWriter {
+public:
+    virtual ~OutputWriter() = default;
+
+    /**
+     * @brief Take the data, which can be reused by the caller once the call returns
+     */
+    virtual void write(const char *data, size_t size) = 0;
+};
+
+/**
+ * @brief The class of output buffer
+ * @details The class of output buffer. All the output of the system is written into an output buffer instead of stdout directly.
+ * If the buffer is bound to a file descriptor, it will be written to the file descriptor when it is full or flushed.
+ * Otherwise, it will grow as needed, and the owner can take the data out, which is how the socket server collects the reply of each client.
+ * A bound buffer can hand the data to an output writer instead, such as the asynchronous writer.
+ */
+class OutputBuffer {
+public:
+    /**
+     * @brief Construct a new OutputBuffer object
+     * @param fd the file descriptor to write to, -1 if the buffer is only kept in memory
+     */
+    explicit OutputBuffer(int fd = -1) : fd_(fd), size_(0), capacity_(kInitialCapacity),
+                                         data_(new char[kInitialCapacity]), writer_(nullptr) {}
+
+    OutputBuffer(const OutputBuffer &) = delete;
+
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    /**
+     * @brief Destroy the OutputBuffer object
+     * @details Destroy the OutputBuffer object, write the remaining data to the file descriptor if it is bound to one
+     */
+    ~OutputBuffer() {
+        flush();
+        delete[] data_;
+    }
+
+    inline void putChar(char c) {
+        reserve(1);
+        data_[size_++] = c;
+    }
+
+    inline void putString(const char *s, size_t length) {
+        reserve(length);
+        memcpy(data_ + size_, s, length);
+        size_ += length;
+    }
+
+    inline void putString(const char *s) {
+        putString(s, strlen(s));
+    }
+
+    inline void putString(const std::string &s) {
+        putString(s.data(), s.size());
+    }
+
+    /**
+     * @brief Put the first length characters of a fixed-size array
+     * @details The whole array is copied, which is a few moves of a constant size instead of a call to memcpy, and only the first length characters are kept
+     */
+    template<size_t kSize>
+    inline void putPrefix(const char (&s)[kSize], size_t length) {
+        reserve(kSize);
+        memcpy(data_ + size_, s, kSize);
+        size_ += length;
+    }
+
+    /**
+     * @brief Put a string and a line break, the same as puts
+     */
+    inline void putLine(const char *s) {
+        putString(s);
+        putChar('\n');
+    }
+
+    /**
+     * @brief Put an integer in decimal
+     */
+    inline void putInt(int x) {
+        char digits[12];
+        int length = 0;
+        unsigned int value = x < 0 ? -static_cast<unsigned int>(x) : x;
+        do {
+            digits[length++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        reserve(length + 1);
+        if (x < 0) {
+            data_[size_++] = '-';
+        }
+        while (length) {
+            data_[size_++] = digits[--length];
+        }
+    }
+
+    /**
+     * @brief Hand the data to an output writer when flushing, instead of writing it to the file descriptor
+     * @param writer the writer writing to the same file descriptor, which must outlive the buffer, nullptr for write(2)
+     */
+    void setWriter(OutputWriter *writer) {
+        writer_ = writer;
+    }
+
+    /**
+     * @brief Write the data to the file descriptor and clear the buffer
+     * @details Nothing happens if the buffer is not bound to a file descriptor
+     */
+    void flush() {
+        if (fd_ < 0) {
+            return;
+        }
+        if (writer_ != nullptr) {
+            writer_->write(data_, size_);
+            size_ = 0;
+            return;
+        }
+        size_t written = 0;
+        while (written < size_) {
+            ssize_t ret = write(fd_, data_ + written, size_ - written);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            written += ret;
+        }
+        size_ = 0;
+    }
+
+    const char *data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Remove the first length bytes, used after a partial write
+     */
+    void consume(size_t length) {
+        if (length >= size_) {
+            size_ = 0;
+        } else {
+            memmove(data_, data_ + length, size_ - length);
+            size_ -= length;
+        }
+    }
+
+private:
+    static const size_t kInitialCapacity = 1 << 16;
+
+    int fd_; // the file descriptor to write to, -1 if the buffer is only kept in memory
+    size_t size_; // the number of bytes in the buffer
+    size_t capacity_; // the capacity of the buffer
+    char *data_; // the data of the buffer
+    OutputWriter *writer_; // the writer taking the data when flushing, nullptr for write(2)
+
+    /**
+     * @brief Make sure there is space for another length bytes
+     * @details If the buffer is bound to a file descriptor, it will be flushed when full. Otherwise, it will grow.
+     */
+    inline void reserve(size_t length) {
+        if (size_ + length <= capacity_) {
+            return;
+        }
+        if (fd_ >= 0) {
+            flush();
+            if (length <= capacity_) {
+                return;
+            }
+        }
+        while (capacity_ < size_ + length) {
+            capacity_ *= 2;
+        }
+        char *data = new char[capacity_];
+        memcpy(data, data_, size_);
+        delete[] data_;
+        data_ = data;
+    }
+};
+
+#endif //ACM_ICPC_MANAGEMENT_OUTPUT_BUFFER_H
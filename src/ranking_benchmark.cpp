@@ -0,0 +1,195 @@
+//
+// Benchmark of the ranking container.
+//
+// It runs the pattern of flush() and scroll() on the ranking records of N teams, on std::set, RankingTree and
+// BucketedRanking: the records are inserted in order, then a random team is erased, solves a problem, is looked up with
+// upper bound and inserted again, and the scoreboard is scanned in order from time to time. It reports the time per
+// update, per scanned team, and per rank lookup of a random team, which std::set does not support.
+//
+// usage: ICPC_ranking_benchmark [--teams N] [--updates U]
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <type_traits>
+
+#include "bucketed_ranking.h"
+
+static const int kMaxProblemCount = 26;
+
+/**
+ * @brief The struct of the ranking record of a team, laid out like ICPCManagementSystem::TeamRanking
+ */
+struct alignas(64) Ranking {
+    int accepted_count_ = 0;
+    int penalty_ = 0;
+    int accepted_time_[kMaxProblemCount] = {};
+};
+
+/**
+ * @brief The functor of comparing the records, by the same rule as ICPCManagementSystem::compareTeam
+ */
+struct CompareRanking {
+    bool operator()(const Ranking *a, const Ranking *b) const {
+        if (a->accepted_count_ != b->accepted_count_) {
+            return a->accepted_count_ > b->accepted_count_;
+        }
+        if (a->penalty_ != b->penalty_) {
+            return a->penalty_ < b->penalty_;
+        }
+        for (int i = 0; i < a->accepted_count_; ++i) {
+            if (a->accepted_time_[i] != b->accepted_time_[i]) {
+                return a->accepted_time_[i] < b->accepted_time_[i];
+            }
+        }
+        return a < b;
+    }
+
+    static unsigned long long getKey(const Ranking *ranking) {
+        return static_cast<unsigned long long>(kMaxProblemCount - ranking->accepted_count_) << 32 |
+               static_cast<unsigned int>(ranking->penalty_);
+    }
+};
+
+/**
+ * @brief The result of a run
+ *
+ * @param build_ The time to insert all the records, in nanoseconds per team
+ * @param update_ The time per update, in nanoseconds
+ * @param scan_ The time per scanned team, in nanoseconds
+ * @param rank_ The time per rank lookup, in nanoseconds, 0 if not supported
+ * @param rank_sum_ The sum of the ranks looked up, the same for the containers supporting it
+ * @param checksum_ The checksum of the order of the scans, the same for all the containers
+ */
+struct Report {
+    double build_;
+    double update_;
+    double scan_;
+    double rank_;
+    unsigned long long rank_sum_;
+    unsigned long long checksum_;
+};
+
+/**
+ * @brief Solve a problem, with the accepted times kept in descending order like Team::setAcceptTime
+ */
+static void solve(Ranking &ranking, int time, int penalty) {
+    if (ranking.accepted_count_ == kMaxProblemCount) {
+        ranking.penalty_ += penalty;
+        return;
+    }
+    memmove(ranking.accepted_time_ + 1, ranking.accepted_time_, ranking.accepted_count_ * sizeof(int));
+    ranking.accepted_time_[0] = time;
+    ++ranking.accepted_count_;
+    ranking.penalty_ += time + penalty;
+}
+
+/**
+ * @brief Print a row of the result, with "-" for the rank lookup if not supported
+ */
+static void printReport(int teams, const char *name, const Report &report) {
+    printf("%-8d %-16s %12.1f %12.1f %12.2f", teams, name, report.build_, report.update_, report.scan_);
+    if (report.rank_ > 0) {
+        printf(" %12.1f\n", report.rank_);
+    } else {
+        printf(" %12s\n", "-");
+    }
+}
+
+template<typename Container, typename UpperBound>
+static Report run(int teams, int updates, UpperBound upper_bound) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<Ranking> rankings(teams);
+    std::mt19937 random(1);
+    Report report{};
+    auto begin = Clock::now();
+    auto *container = new Container();
+    for (auto &ranking: rankings) {
+        container->insert(&ranking);
+    }
+    report.build_ = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / teams;
+
+    const int scan_interval = std::max(1, updates / 20);
+    double update_time = 0, scan_time = 0;
+    long long scanned = 0;
+    for (int i = 0; i < updates; i += scan_interval) {
+        int count = std::min(scan_interval, updates - i);
+        begin = Clock::now();
+        for (int j = 0; j < count; ++j) {
+            Ranking *ranking = &rankings[random() % teams];
+            container->erase(ranking);
+            auto before = upper_bound(*container, ranking);
+            solve(*ranking, (i + j) / 100 + 1, static_cast<int>(random() % 3) * 20);
+            auto after = upper_bound(*container, ranking);
+            report.checksum_ += before != after;
+            container->insert(ranking);
+        }
+        auto middle = Clock::now();
+        for (Ranking *ranking: *container) {
+            report.checksum_ = report.checksum_ * 31 + (ranking - rankings.data());
+            ++scanned;
+        }
+        update_time += std::chrono::duration<double, std::nano>(middle - begin).count();
+        scan_time += std::chrono::duration<double, std::nano>(Clock::now() - middle).count();
+    }
+    if constexpr (!std::is_same_v<Container, std::set<Ranking *, CompareRanking>>) {
+        begin = Clock::now();
+        for (int i = 0; i < updates; ++i) {
+            report.rank_sum_ += container->rank(&rankings[random() % teams]);
+        }
+        report.rank_ = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / updates;
+    }
+    delete container;
+    report.update_ = update_time / updates;
+    report.scan_ = scan_time / static_cast<double>(scanned);
+    return report;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<int> team_counts = {10000, 100000, 1000000};
+    int updates = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--teams") == 0 && i + 1 < argc) {
+            team_counts = {atoi(argv[++i])};
+        } else if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc) {
+            updates = atoi(argv[++i]);
+        } else {
+            updates = 0;
+            break;
+        }
+    }
+    if (updates <= 0 || team_counts[0] <= 0) {
+        fprintf(stderr, "usage: %s [--teams N] [--updates U]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-8s %-16s %12s %12s %12s %12s\n", "teams", "container", "build ns", "update ns", "scan ns", "rank ns");
+    for (int teams: team_counts) {
+        Report set = run<std::set<Ranking *, CompareRanking>>(teams, updates, [](auto &container, Ranking *ranking) {
+            return container.upper_bound(ranking);
+        });
+        Report tree = run<RankingTree<Ranking *, CompareRanking>>(teams, updates, [](auto &container,
+                                                                                     Ranking *ranking) {
+            return container.upperBound(ranking);
+        });
+        Report bucketed = run<BucketedRanking<Ranking *, CompareRanking, kMaxProblemCount + 1>>(
+                teams, updates, [](auto &container, Ranking *ranking) {
+                    return container.upperBound(ranking);
+                });
+        printReport(teams, "std::set", set);
+        printReport(teams, "RankingTree", tree);
+        printReport(teams, "BucketedRanking", bucketed);
+        if (set.checksum_ != tree.checksum_ || set.checksum_ != bucketed.checksum_ ||
+            tree.rank_sum_ != bucketed.rank_sum_) {
+            fprintf(stderr, "the orders of the containers differ\n");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,622 @@
+#ifndef ACM_ICPC_MANAGEMENT_RANKING_TREE_H
+#define ACM_ICPC_MANAGEMENT_RANKING_TREE_H
+
+#include <cstddef>
+#include <cstring>
+
+/**
+ * @brief The class of ranking tree
+ * @details The class of ranking tree, a B+-tree set of values ordered by a packed 64-bit key, and by the comparator only when the keys are equal.
+ * A node holds the keys, then the values, of up to kNodeSize entries in consecutive cache lines, so a search in a node scans the keys of two cache lines and seldom reads the values.
+ * The entries are in the leaves, which are linked for the in-order scan, and an inner node holds the first entry of each child but the first as the separators, and the number of entries under each child, which finds the rank of a value and the value at a rank.
+ * The key of a value must not change while the value is in the tree, so a value is erased, updated and inserted again.
+ *
+ * @tparam Value the type of the values, such as a pointer
+ * @tparam Compare the functor comparing two values, with a static getKey packing a value into its key. A less key means a less value.
+ */
+template<typename Value, typename Compare>
+class RankingTree {
+    struct Leaf;
+
+public:
+    /**
+     * @brief The class of iterator, which walks the entries in order along the leaves
+     */
+    class Iterator {
+    public:
+        Iterator(const Leaf *leaf, int index) : leaf_(leaf), index_(index) {
+            skipEmpty();
+        }
+
+        Value operator*() const {
+            return leaf_->values_[index_];
+        }
+
+        Iterator &operator++() {
+            ++index_;
+            skipEmpty();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const {
+            return leaf_ == other.leaf_ && index_ == other.index_;
+        }
+
+        bool operator!=(const Iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        const Leaf *leaf_; // the leaf, nullptr for the end
+        int index_; // the index of the entry in the leaf
+
+        void skipEmpty() {
+            while (leaf_ != nullptr && index_ >= leaf_->count_) {
+                leaf_ = leaf_->next_;
+                index_ = 0;
+            }
+        }
+    };
+
+    RankingTree() : root_(new Leaf()), height_(0), size_(0) {
+        head_ = static_cast<Leaf *>(root_);
+    }
+
+    RankingTree(const RankingTree &) = delete;
+
+    RankingTree &operator=(const RankingTree &) = delete;
+
+    ~RankingTree() {
+        release(root_, height_);
+    }
+
+    Iterator begin() const {
+        return Iterator(head_, 0);
+    }
+
+    Iterator end() const {
+        return Iterator(nullptr, 0);
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    /**
+     * @brief Insert a value, which is not in the tree
+     * @details A full leaf is split in halves, except the last leaf when the value goes to its end, which keeps all its entries, so inserting the values in order fills the leaves
+     */
+    void insert(Value value) {
+        const unsigned long long key = Compare::getKey(value);
+        Inner *path[kMaxHeight];
+        int positions[kMaxHeight];
+        Leaf *leaf = descend(key, value, path, positions);
+        int position = upperPosition(leaf, key, value);
+        ++size_;
+        for (int level = 1; level <= height_; ++level) {
+            ++path[level]->sizes_[positions[level]];
+        }
+        if (leaf->count_ < kNodeSize) {
+            insertEntry(leaf, position, key, value);
+            return;
+        }
+        auto *right = new Leaf();
+        int half = leaf->next_ == nullptr && position == kNodeSize ? kNodeSize : kNodeSize / 2;
+        moveEntries(right, 0, leaf, half, kNodeSize - half);
+        right->count_ = kNodeSize - half;
+        leaf->count_ = half;
+        right->next_ = leaf->next_;
+        leaf->next_ = right;
+        if (position < half) {
+            insertEntry(leaf, position, key, value);
+        } else {
+            insertEntry(right, position - half, key, value);
+        }
+        // the first entry of the new leaf is the separator in the parent
+        unsigned long long separator_key = right->keys_[0];
+        Value separator_value = right->values_[0];
+        Node *child = right;
+        size_t left_size = leaf->count_, right_size = right->count_;
+        for (int level = 1; level <= height_; ++level) {
+            Inner *parent = path[level];
+            position = positions[level];
+            parent->sizes_[position] = left_size;
+            if (parent->count_ < kNodeSize) {
+                insertSeparator(parent, position, separator_key, separator_value, child, right_size);
+                return;
+            }
+            left_size = splitInner(parent, position, separator_key, separator_value, child, right_size);
+        }
+        auto *root = new Inner();
+        root->count_ = 1;
+        root->keys_[0] = separator_key;
+        root->values_[0] = separator_value;
+        root->children_[0] = root_;
+        root->children_[1] = child;
+        root->sizes_[0] = left_size;
+        root->sizes_[1] = right_size;
+        root_ = root;
+        ++height_;
+    }
+
+    /**
+     * @brief Build the tree from sorted values, in O(count) time
+     * @param count the number of values
+     * @param get the function returning the value at an index in [0, count)
+     * @details The tree must be empty, and the values must be in increasing order without equal ones.
+     * The leaves are filled left to right, then each level of inner nodes is built from the one below it with the sizes of the children, and the first entry of each child but the first as the separators.
+     * The nodes are full except the last two of a level, which share their entries evenly if the last one would be less than half full.
+     */
+    template<typename Function>
+    void build(size_t count, Function get) {
+        if (count == 0) {
+            return;
+        }
+        size_ = count;
+        size_t width = (count + kNodeSize - 1) / kNodeSize;
+        auto **level = new Node *[width];
+        auto *sizes = new size_t[width];
+        auto *first_keys = new unsigned long long[width];
+        auto *first_values = new Value[width];
+        Leaf *previous = nullptr;
+        for (size_t i = 0, offset = 0; i < width; ++i) {
+            // the first leaf is the empty root, which is never freed
+            Leaf *leaf = i == 0 ? head_ : new Leaf();
+            int entries = static_cast<int>(getChunkSize(count, kNodeSize, i));
+            for (int j = 0; j < entries; ++j) {
+                leaf->values_[j] = get(offset + j);
+                leaf->keys_[j] = Compare::getKey(leaf->values_[j]);
+            }
+            leaf->count_ = entries;
+            if (previous != nullptr) {
+                previous->next_ = leaf;
+            }
+            previous = leaf;
+            level[i] = leaf;
+            sizes[i] = entries;
+            first_keys[i] = leaf->keys_[0];
+            first_values[i] = leaf->values_[0];
+            offset += entries;
+        }
+        while (width > 1) {
+            size_t parents = (width + kNodeSize) / (kNodeSize + 1);
+            // the parent i takes its children from index i or later, so the level is rewritten in place
+            for (size_t i = 0, child = 0; i < parents; ++i) {
+                auto *inner = new Inner();
+                int children = static_cast<int>(getChunkSize(width, kNodeSize + 1, i));
+                size_t size = 0;
+                for (int j = 0; j < children; ++j) {
+                    inner->children_[j] = level[child + j];
+                    inner->sizes_[j] = sizes[child + j];
+                    size += sizes[child + j];
+                    if (j > 0) {
+                        inner->keys_[j - 1] = first_keys[child + j];
+                        inner->values_[j - 1] = first_values[child + j];
+                    }
+                }
+                inner->count_ = children - 1;
+                level[i] = inner;
+                sizes[i] = size;
+                first_keys[i] = first_keys[child];
+                first_values[i] = first_values[child];
+                child += children;
+            }
+            width = parents;
+            ++height_;
+        }
+        root_ = level[0];
+        delete[] level;
+        delete[] sizes;
+        delete[] first_keys;
+        delete[] first_values;
+    }
+
+    /**
+     * @brief Erase a value, which is in the tree with the same key as it was inserted
+     * @details A node left with less than half of kNodeSize entries borrows one from a sibling, or is merged with it.
+     * A separator equal to the value is replaced by the next value, since the comparator of the equal keys reads the value, which may change once it is erased.
+     */
+    void erase(Value value) {
+        const unsigned long long key = Compare::getKey(value);
+        Inner *path[kMaxHeight];
+        int positions[kMaxHeight];
+        Leaf *leaf = descend(key, value, path, positions);
+        int position = lowerPosition(leaf, key, value);
+        if (position == leaf->count_ || leaf->values_[position] != value) {
+            return;
+        }
+        bool separator = false;
+        for (int level = 1; level <= height_; ++level) {
+            separator |= positions[level] > 0 && path[level]->values_[positions[level] - 1] == value;
+            --path[level]->sizes_[positions[level]];
+        }
+        --size_;
+        moveEntries(leaf, position, leaf, position + 1, leaf->count_ - position - 1);
+        --leaf->count_;
+        Node *node = leaf;
+        for (int level = 1; level <= height_ && node->count_ < kMinCount; ++level) {
+            rebalance(path[level], positions[level], level == 1);
+            node = path[level];
+        }
+        if (height_ > 0 && root_->count_ == 0) {
+            auto *root = static_cast<Inner *>(root_);
+            root_ = root->children_[0];
+            delete root;
+            --height_;
+        }
+        if (separator) {
+            replaceSeparator(key, value);
+        }
+    }
+
+    /**
+     * @brief Find the first value greater than a value, which is usually not in the tree
+     */
+    Iterator upperBound(Value value) const {
+        const unsigned long long key = Compare::getKey(value);
+        Inner *path[kMaxHeight];
+        int positions[kMaxHeight];
+        Leaf *leaf = descend(key, value, path, positions);
+        return Iterator(leaf, upperPosition(leaf, key, value));
+    }
+
+    /**
+     * @brief Get the number of values less than a value
+     */
+    size_t rank(Value value) const {
+        const unsigned long long key = Compare::getKey(value);
+        size_t rank = 0;
+        Node *node = root_;
+        for (int level = height_; level > 0; --level) {
+            auto *inner = static_cast<Inner *>(node);
+            int position = upperPosition(inner, key, value);
+            for (int i = 0; i < position; ++i) {
+                rank += inner->sizes_[i];
+            }
+            node = inner->children_[position];
+        }
+        return rank + lowerPosition(node, key, value);
+    }
+
+    /**
+     * @brief Find the value at a position in the order, starting from 0
+     * @return The iterator to the value, end() if the position is not less than size()
+     */
+    Iterator at(size_t position) const {
+        if (position >= size_) {
+            return end();
+        }
+        Node *node = root_;
+        for (int level = height_; level > 0; --level) {
+            auto *inner = static_cast<Inner *>(node);
+            int i = 0;
+            while (position >= inner->sizes_[i]) {
+                position -= inner->sizes_[i];
+                ++i;
+            }
+            node = inner->children_[i];
+        }
+        return Iterator(static_cast<Leaf *>(node), static_cast<int>(position));
+    }
+
+private:
+    static const int kNodeSize = 16; // the maximum number of entries of a leaf, or of separators of an inner node
+    static const int kMinCount = kNodeSize / 2; // the minimum number of entries or separators of a node but the root
+    static const int kMaxHeight = 16; // the maximum height of the tree, enough for any number of values in memory
+
+    /**
+     * @brief The struct of node
+     *
+     * @param keys_ The keys of the entries, or of the separators
+     * @param values_ The values of the entries, or of the separators
+     * @param count_ The number of entries, or of separators
+     */
+    struct alignas(64) Node {
+        unsigned long long keys_[kNodeSize];
+        Value values_[kNodeSize];
+        int count_ = 0;
+    };
+
+    /**
+     * @brief The struct of leaf
+     *
+     * @param next_ The next leaf, nullptr for the last one
+     */
+    struct Leaf : Node {
+        Leaf *next_ = nullptr;
+    };
+
+    /**
+     * @brief The struct of inner node
+     * @details The entries of children_[i] are not less than the separator i - 1, and less than the separator i
+     *
+     * @param children_ The children, count_ + 1 of them
+     * @param sizes_ The number of entries under each child
+     */
+    struct Inner : Node {
+        Node *children_[kNodeSize + 1];
+        size_t sizes_[kNodeSize + 1];
+    };
+
+    Node *root_; // the root, a leaf if height_ is 0
+    int height_; // the number of levels of inner nodes
+    size_t size_; // the number of values
+    Leaf *head_; // the first leaf, which is never freed
+    Compare compare_; // the comparator of the values with the same key
+
+    /**
+     * @brief Get the number of entries of a node not greater than a value
+     */
+    int upperPosition(const Node *node, unsigned long long key, Value value) const {
+        int i = 0;
+        while (i < node->count_ && node->keys_[i] < key) {
+            ++i;
+        }
+        while (i < node->count_ && node->keys_[i] == key && !compare_(value, node->values_[i])) {
+            ++i;
+        }
+        return i;
+    }
+
+    /**
+     * @brief Get the number of entries of a node less than a value
+     */
+    int lowerPosition(const Node *node, unsigned long long key, Value value) const {
+        int i = 0;
+        while (i < node->count_ && node->keys_[i] < key) {
+            ++i;
+        }
+        while (i < node->count_ && node->keys_[i] == key && compare_(node->values_[i], value)) {
+            ++i;
+        }
+        return i;
+    }
+
+    /**
+     * @brief Find the leaf where a value is or would be
+     * @param path the inner node of each level on the way, path[height_] is the root
+     * @param positions the index of the child taken in each inner node
+     */
+    Leaf *descend(unsigned long long key, Value value, Inner **path, int *positions) const {
+        Node *node = root_;
+        for (int level = height_; level > 0; --level) {
+            auto *inner = static_cast<Inner *>(node);
+            int position = upperPosition(inner, key, value);
+            path[level] = inner;
+            positions[level] = position;
+            node = inner->children_[position];
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    /**
+     * @brief Replace the separator equal to an erased value by the next value
+     * @details The separator is on the way to the value, and there is only one, since the value is the first entry of the subtree after it
+     */
+    void replaceSeparator(unsigned long long key, Value value) {
+        Iterator next = upperBound(value);
+        Node *node = root_;
+        for (int level = height_; level > 0 && next != end(); --level) {
+            auto *inner = static_cast<Inner *>(node);
+            int position = upperPosition(inner, key, value);
+            if (position > 0 && inner->values_[position - 1] == value) {
+                inner->keys_[position - 1] = Compare::getKey(*next);
+                inner->values_[position - 1] = *next;
+                return;
+            }
+            node = inner->children_[position];
+        }
+    }
+
+    /**
+     * @brief Get the number of items of a node in a level built by build
+     * @param total the number of items of the level, entries for the leaves or children for the inner nodes
+     * @param capacity the maximum number of items of a node
+     * @param index the index of the node in the level
+     */
+    static size_t getChunkSize(size_t total, size_t capacity, size_t index) {
+        size_t nodes = (total + capacity - 1) / capacity;
+        size_t last = total - (nodes - 1) * capacity;
+        if (nodes == 1 || last * 2 >= capacity || index + 2 < nodes) {
+            return index + 1 < nodes ? capacity : last;
+        }
+        // the last two nodes share their items, so both are at least half full
+        size_t shared = capacity + last;
+        return index + 2 == nodes ? shared - shared / 2 : shared / 2;
+    }
+
+    static void moveEntries(Node *to, int to_index, const Node *from, int from_index, int count) {
+        if (count > 0) {
+            memmove(to->keys_ + to_index, from->keys_ + from_index, count * sizeof(unsigned long long));
+            memmove(to->values_ + to_index, from->values_ + from_index, count * sizeof(Value));
+        }
+    }
+
+    static void moveChildren(Inner *to, int to_index, const Inner *from, int from_index, int count) {
+        if (count > 0) {
+            memmove(to->children_ + to_index, from->children_ + from_index, count * sizeof(Node *));
+            memmove(to->sizes_ + to_index, from->sizes_ + from_index, count * sizeof(size_t));
+        }
+    }
+
+    static void insertEntry(Node *node, int position, unsigned long long key, Value value) {
+        moveEntries(node, position + 1, node, position, node->count_ - position);
+        node->keys_[position] = key;
+        node->values_[position] = value;
+        ++node->count_;
+    }
+
+    /**
+     * @brief Insert a separator and the child after it into an inner node which is not full
+     */
+    static void insertSeparator(Inner *inner, int position, unsigned long long key, Value value, Node *child,
+                                size_t size) {
+        moveChildren(inner, position + 2, inner, position + 1, inner->count_ - position);
+        insertEntry(inner, position, key, value);
+        inner->children_[position + 1] = child;
+        inner->sizes_[position + 1] = size;
+    }
+
+    /**
+     * @brief Remove a separator and the child after it from an inner node
+     */
+    static void removeSeparator(Inner *inner, int position) {
+        moveEntries(inner, position, inner, position + 1, inner->count_ - position - 1);
+        moveChildren(inner, position + 1, inner, position + 2, inner->count_ - position - 1);
+        --inner->count_;
+    }
+
+    /**
+     * @brief Split a full inner node while inserting a separator and the child after it
+     * @details The middle separator moves up, and becomes the separator and the child to insert into the parent, and size becomes the number of entries under the new child
+     * @return The number of entries left under the node
+     */
+    static size_t splitInner(Inner *inner, int position, unsigned long long &key, Value &value, Node *&child,
+                             size_t &size) {
+        unsigned long long keys[kNodeSize + 1];
+        Value values[kNodeSize + 1];
+        Node *children[kNodeSize + 2];
+        size_t sizes[kNodeSize + 2];
+        memcpy(keys, inner->keys_, position * sizeof(unsigned long long));
+        memcpy(values, inner->values_, position * sizeof(Value));
+        memcpy(children, inner->children_, (position + 1) * sizeof(Node *));
+        memcpy(sizes, inner->sizes_, (position + 1) * sizeof(size_t));
+        keys[position] = key;
+        values[position] = value;
+        children[position + 1] = child;
+        sizes[position + 1] = size;
+        memcpy(keys + position + 1, inner->keys_ + position, (kNodeSize - position) * sizeof(unsigned long long));
+        memcpy(values + position + 1, inner->values_ + position, (kNodeSize - position) * sizeof(Value));
+        memcpy(children + position + 2, inner->children_ + position + 1, (kNodeSize - position) * sizeof(Node *));
+        memcpy(sizes + position + 2, inner->sizes_ + position + 1, (kNodeSize - position) * sizeof(size_t));
+        const int half = (kNodeSize + 1) / 2;
+        auto *right = new Inner();
+        memcpy(inner->keys_, keys, half * sizeof(unsigned long long));
+        memcpy(inner->values_, values, half * sizeof(Value));
+        memcpy(inner->children_, children, (half + 1) * sizeof(Node *));
+        memcpy(inner->sizes_, sizes, (half + 1) * sizeof(size_t));
+        inner->count_ = half;
+        right->count_ = kNodeSize - half;
+        memcpy(right->keys_, keys + half + 1, right->count_ * sizeof(unsigned long long));
+        memcpy(right->values_, values + half + 1, right->count_ * sizeof(Value));
+        memcpy(right->children_, children + half + 1, (right->count_ + 1) * sizeof(Node *));
+        memcpy(right->sizes_, sizes + half + 1, (right->count_ + 1) * sizeof(size_t));
+        key = keys[half];
+        value = values[half];
+        child = right;
+        size = 0;
+        for (int i = 0; i <= right->count_; ++i) {
+            size += right->sizes_[i];
+        }
+        size_t left_size = 0;
+        for (int i = 0; i <= inner->count_; ++i) {
+            left_size += inner->sizes_[i];
+        }
+        return left_size;
+    }
+
+    /**
+     * @brief Refill a child with too few entries, by borrowing one from a sibling, or merging it with a sibling
+     * @param parent the parent
+     * @param index the index of the child
+     * @param leaf whether the child is a leaf
+     */
+    void rebalance(Inner *parent, int index, bool leaf) {
+        Node *child = parent->children_[index];
+        Node *left = index > 0 ? parent->children_[index - 1] : nullptr;
+        Node *right = index < parent->count_ ? parent->children_[index + 1] : nullptr;
+        if (left != nullptr && left->count_ > kMinCount) {
+            if (leaf) {
+                insertEntry(child, 0, left->keys_[left->count_ - 1], left->values_[left->count_ - 1]);
+                --left->count_;
+                parent->keys_[index - 1] = child->keys_[0];
+                parent->values_[index - 1] = child->values_[0];
+                --parent->sizes_[index - 1];
+                ++parent->sizes_[index];
+            } else {
+                auto *inner = static_cast<Inner *>(child);
+                auto *left_inner = static_cast<Inner *>(left);
+                size_t moved = left_inner->sizes_[left->count_];
+                moveChildren(inner, 1, inner, 0, inner->count_ + 1);
+                inner->children_[0] = left_inner->children_[left->count_];
+                inner->sizes_[0] = moved;
+                parent->sizes_[index - 1] -= moved;
+                parent->sizes_[index] += moved;
+                insertEntry(inner, 0, parent->keys_[index - 1], parent->values_[index - 1]);
+                --left->count_;
+                parent->keys_[index - 1] = left->keys_[left->count_];
+                parent->values_[index - 1] = left->values_[left->count_];
+            }
+        } else if (right != nullptr && right->count_ > kMinCount) {
+            if (leaf) {
+                insertEntry(child, child->count_, right->keys_[0], right->values_[0]);
+                moveEntries(right, 0, right, 1, right->count_ - 1);
+                --right->count_;
+                parent->keys_[index] = right->keys_[0];
+                parent->values_[index] = right->values_[0];
+                --parent->sizes_[index + 1];
+                ++parent->sizes_[index];
+            } else {
+                auto *inner = static_cast<Inner *>(child);
+                auto *right_inner = static_cast<Inner *>(right);
+                size_t moved = right_inner->sizes_[0];
+                inner->children_[inner->count_ + 1] = right_inner->children_[0];
+                inner->sizes_[inner->count_ + 1] = moved;
+                parent->sizes_[index + 1] -= moved;
+                parent->sizes_[index] += moved;
+                insertEntry(inner, inner->count_, parent->keys_[index], parent->values_[index]);
+                parent->keys_[index] = right->keys_[0];
+                parent->values_[index] = right->values_[0];
+                moveEntries(right, 0, right, 1, right->count_ - 1);
+                moveChildren(right_inner, 0, right_inner, 1, right->count_);
+                --right->count_;
+            }
+        } else {
+            // the siblings have no entry to spare, so the child and one of them fit in one node
+            int merged = left != nullptr ? index - 1 : index;
+            merge(parent, merged, leaf);
+        }
+    }
+
+    /**
+     * @brief Merge a child of an inner node with the child after it
+     * @param parent the parent
+     * @param index the index of the first child
+     * @param leaf whether the children are leaves
+     */
+    void merge(Inner *parent, int index, bool leaf) {
+        Node *left = parent->children_[index];
+        Node *right = parent->children_[index + 1];
+        parent->sizes_[index] += parent->sizes_[index + 1];
+        if (leaf) {
+            moveEntries(left, left->count_, right, 0, right->count_);
+            left->count_ += right->count_;
+            static_cast<Leaf *>(left)->next_ = static_cast<Leaf *>(right)->next_;
+            delete static_cast<Leaf *>(right);
+        } else {
+            auto *left_inner = static_cast<Inner *>(left);
+            auto *right_inner = static_cast<Inner *>(right);
+            left->keys_[left->count_] = parent->keys_[index];
+            left->values_[left->count_] = parent->values_[index];
+            moveEntries(left, left->count_ + 1, right, 0, right->count_);
+            moveChildren(left_inner, left->count_ + 1, right_inner, 0, right->count_ + 1);
+            left->count_ += right->count_ + 1;
+            delete right_inner;
+        }
+        removeSeparator(parent, index);
+    }
+
+    static void release(Node *node, int height) {
+        if (height == 0) {
+            delete static_cast<Leaf *>(node);
+            return;
+        }
+        auto *inner = static_cast<Inner *>(node);
+        for (int i = 0; i <= inner->count_; ++i) {
+            release(inner->children_[i], height - 1);
+        }
+        delete inner;
+    }
+};
+
+#endif //ACM_ICPC_MANAGEMENT_RANKING_TREE_H
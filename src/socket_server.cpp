@@ -0,0 +1,357 @@
+#include "socket_server.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+volatile sig_atomic_t SocketServer::stop_requested_ = 0;
+
+SocketServer::SocketServer(ICPCManagementSystem &system, int loops) : system_(system),
+                                                                    concurrent_reads_(loops > 1),
+                                                                    listen_fd_(-1), next_loop_(0),
+                                                                    ended_(false) {
+    for (int i = 0; i < loops; ++i) {
+        loops_.push_back(new EventLoop(i));
+    }
+    if (concurrent_reads_) {
+        system_.enableConcurrentReads();
+    }
+}
+
+SocketServer::~SocketServer() {
+    for (auto loop: loops_) {
+        for (auto &item: loop->clients_) {
+            close(item.first);
+            delete item.second;
+        }
+        if (loop->epoll_fd_ >= 0) {
+            close(loop->epoll_fd_);
+        }
+        if (loop->wake_fd_ >= 0) {
+            close(loop->wake_fd_);
+        }
+        delete loop;
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+    }
+    if (!unix_path_.empty()) {
+        unlink(unix_path_.c_str());
+    }
+}
+
+bool SocketServer::listenUnix(const char *path) {
+    sockaddr_un address{};
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "socket path is too long: %s\n", path);
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);
+    if (listen_fd_ < 0 || bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd_, SOMAXCONN) < 0) {
+        perror("listen on unix socket");
+        return false;
+    }
+    unix_path_ = path;
+    return setUpEpoll();
+}
+
+bool SocketServer::listenTcp(int port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int reuse = 1;
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0 || setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+        bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd_, SOMAXCONN) < 0) {
+        perror("listen on tcp port");
+        return false;
+    }
+    return setUpEpoll();
+}
+
+bool SocketServer::setUpEpoll() {
+    for (auto loop: loops_) {
+        loop->epoll_fd_ = epoll_create1(0);
+        loop->wake_fd_ = eventfd(0, EFD_NONBLOCK);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr; // nullptr stands for the eventfd or the listening socket
+        if (loop->epoll_fd_ < 0 || loop->wake_fd_ < 0 ||
+            epoll_ctl(loop->epoll_fd_, EPOLL_CTL_ADD, loop->wake_fd_, &event) < 0) {
+            perror("epoll");
+            return false;
+        }
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (!setNonBlocking(listen_fd_) || epoll_ctl(loops_[0]->epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) < 0) {
+        perror("epoll");
+        return false;
+    }
+    return true;
+}
+
+int SocketServer::run() {
+    struct sigaction action{};
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    // the signals are only handled by the first event loop
+    sigset_t signals, previous_signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous_signals);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < loops_.size(); ++i) {
+        threads.emplace_back(&SocketServer::runLoop, this, loops_[i]);
+    }
+    pthread_sigmask(SIG_SETMASK, &previous_signals, nullptr);
+    int ret = runLoop(loops_[0]);
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    return ret;
+}
+
+int SocketServer::runLoop(EventLoop *loop) {
+    epoll_event events[kMaxEvents];
+    int ret = 0;
+    while (!ended_.load(std::memory_order_relaxed)) {
+        if (stop_requested_) {
+            stopLoops();
+            break;
+        }
+        int count = epoll_wait(loop->epoll_fd_, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            stopLoops();
+            ret = 1;
+            break;
+        }
+        for (int i = 0; i < count && !ended_.load(std::memory_order_relaxed); ++i) {
+            auto *client = static_cast<Client *>(events[i].data.ptr);
+            if (client == nullptr) {
+                if (loop->id_ == 0) {
+                    acceptClients();
+                }
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                readClient(loop, client);
+            } else if (events[i].events & EPOLLOUT) {
+                writeClient(loop, client);
+            }
+        }
+    }
+    // send the pending replies, including the reply of "END", before closing
+    std::vector<Client *> pending;
+    {
+        // the lock only guards the map against the accepting loop, and is not held while sending
+        std::lock_guard<std::mutex> lock(loop->clients_mutex_);
+        for (auto &item: loop->clients_) {
+            if (!item.second->output_.empty()) {
+                pending.push_back(item.second);
+            }
+        }
+    }
+    drainClients(pending);
+    return ret;
+}
+
+void SocketServer::drainClients(std::vector<Client *> &pending) {
+    // a client which has stopped reading cannot hold the shutdown for longer than kDrainTimeout
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kDrainTimeout);
+    std::vector<pollfd> fds;
+    while (true) {
+        for (size_t i = 0; i < pending.size();) {
+            if (sendPending(pending[i])) {
+                pending[i] = pending.back();
+                pending.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        if (pending.empty()) {
+            return;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) {
+            // the unsent output is dropped
+            return;
+        }
+        fds.clear();
+        for (Client *client: pending) {
+            fds.push_back(pollfd{client->fd_, POLLOUT, 0});
+        }
+        if (poll(fds.data(), fds.size(), static_cast<int>(remaining)) < 0 && errno != EINTR) {
+            return;
+        }
+    }
+}
+
+bool SocketServer::sendPending(Client *client) {
+    while (!client->output_.empty()) {
+        ssize_t ret = send(client->fd_, client->output_.data(), client->output_.size(), MSG_NOSIGNAL);
+        if (ret > 0) {
+            client->output_.consume(ret);
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && errno == EAGAIN) {
+            return false;
+        } else {
+            // the connection is broken, and the rest is dropped
+            return true;
+        }
+    }
+    return true;
+}
+
+void SocketServer::stopLoops() {
+    ended_.store(true);
+    for (auto loop: loops_) {
+        eventfd_write(loop->wake_fd_, 1);
+    }
+}
+
+void SocketServer::acceptClients() {
+    while (true) {
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) {
+            // EAGAIN when all the pending connections are accepted
+            return;
+        }
+        if (!unix_path_.empty() || [fd] {
+            int no_delay = 1;
+            return setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay)) == 0;
+        }()) {
+            EventLoop *loop = loops_[next_loop_];
+            next_loop_ = (next_loop_ + 1) % static_cast<int>(loops_.size());
+            auto *client = new Client(fd);
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.ptr = client;
+            if (setNonBlocking(fd)) {
+                std::lock_guard<std::mutex> lock(loop->clients_mutex_);
+                loop->clients_[fd] = client;
+                if (epoll_ctl(loop->epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0) {
+                    continue;
+                }
+                loop->clients_.erase(fd);
+            }
+            delete client;
+        }
+        close(fd);
+    }
+}
+
+void SocketServer::readClient(EventLoop *loop, Client *client) {
+    while (!client->closing_) {
+        ssize_t ret = read(client->fd_, loop->buffer_, kReadChunkSize);
+        if (ret > 0) {
+            client->input_.append(loop->buffer_, ret);
+            if (ret < static_cast<ssize_t>(kReadChunkSize)) {
+                break;
+            }
+        } else if (ret == 0 || (errno != EAGAIN && errno != EINTR)) {
+            // the client has closed its side
+            client->closing_ = true;
+        } else if (errno == EAGAIN) {
+            break;
+        }
+    }
+    // execute the complete command lines in order
+    size_t begin = 0, end;
+    while (!ended_.load(std::memory_order_relaxed) && (end = client->input_.find('\n', begin)) != std::string::npos) {
+        client->input_[end] = '\0';
+        executeCommand(loop, client, client->input_.c_str() + begin);
+        begin = end + 1;
+    }
+    client->input_.erase(0, begin);
+    if (client->input_.size() > kMaxPendingInput) {
+        closeClient(loop, client);
+        return;
+    }
+    if (client->closing_ && !client->input_.empty() && !ended_.load(std::memory_order_relaxed)) {
+        // the last command line without a line break
+        executeCommand(loop, client, client->input_.c_str());
+        client->input_.clear();
+    }
+    writeClient(loop, client);
+}
+
+void SocketServer::executeCommand(EventLoop *loop, Client *client, const char *line) {
+    if (concurrent_reads_ && system_.executeReadOnlyCommand(line, client->output_, loop->id_)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(system_mutex_);
+    if (ended_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    system_.setOutput(&client->output_);
+    if (!system_.executeCommand(line)) {
+        stopLoops();
+    }
+}
+
+void SocketServer::writeClient(EventLoop *loop, Client *client) {
+    while (!client->output_.empty()) {
+        ssize_t ret = send(client->fd_, client->output_.data(), client->output_.size(), MSG_NOSIGNAL);
+        if (ret > 0) {
+            client->output_.consume(ret);
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && errno == EAGAIN) {
+            break;
+        } else {
+            closeClient(loop, client);
+            return;
+        }
+    }
+    if (ended_.load(std::memory_order_relaxed)) {
+        // the rest will be sent before the server stops
+        return;
+    }
+    if (client->output_.empty() && client->closing_) {
+        closeClient(loop, client);
+        return;
+    }
+    bool writing = !client->output_.empty();
+    if (writing != client->writing_) {
+        epoll_event event{};
+        event.events = writing ? EPOLLIN | EPOLLOUT : EPOLLIN;
+        event.data.ptr = client;
+        epoll_ctl(loop->epoll_fd_, EPOLL_CTL_MOD, client->fd_, &event);
+        client->writing_ = writing;
+    }
+}
+
+void SocketServer::closeClient(EventLoop *loop, Client *client) {
+    epoll_ctl(loop->epoll_fd_, EPOLL_CTL_DEL, client->fd_, nullptr);
+    close(client->fd_);
+    std::lock_guard<std::mutex> lock(loop->clients_mutex_);
+    loop->clients_.erase(client->fd_);
+    delete client;
+}
@@ -0,0 +1,210 @@
+#ifndef ACM_ICPC_MANAGEMENT_SOCKET_SERVER_H
+#define ACM_ICPC_MANAGEMENT_SOCKET_SERVER_H
+
+#include <csignal>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+
+#include "icpc_management_system.h"
+#include "output_buffer.h"
+
+/**
+ * @brief The class of socket server
+ * @details The class of socket server, which serves the system to many concurrent judge and scoreboard clients on a Unix domain socket or a loopback TCP port.
+ * The clients are multiplexed with epoll by one or more event loops, each of which runs on its own thread and owns the clients assigned to it in turn.
+ * The commands of a client are executed in the order they are read. The mutating commands of all the clients are funneled into the single ICPCManagementSystem instance one at a time under a lock, so they are applied in order.
+ * With more than one event loop, the concurrent read path is enabled, and QUERY_RANKING and QUERY_SUBMISSION are answered on the event loop threads without the lock, so the throughput of the queries scales with the cores.
+ * Each client sends commands line by line, with the same format as stdin, and receives the same output as stdout. The reply is sent as soon as the commands read in one batch are executed.
+ * The server stops when any client sends "END", or when SIGINT or SIGTERM is received.
+ */
+class SocketServer {
+public:
+    /**
+     * @brief Construct a new SocketServer object
+     * @param system the system to execute the commands
+     * @param loops the number of event loops, in [1, ICPCManagementSystem::kMaxReaders]
+     */
+    SocketServer(ICPCManagementSystem &system, int loops);
+
+    SocketServer(const SocketServer &) = delete;
+
+    SocketServer &operator=(const SocketServer &) = delete;
+
+    /**
+     * @brief Destroy the SocketServer object
+     * @details Destroy the SocketServer object, close all the clients and the listening socket, and remove the socket file
+     */
+    ~SocketServer();
+
+    /**
+     * @brief Listen on a Unix domain socket
+     * @param path the path of the socket file, which is replaced if it exists
+     * @error If the socket cannot be created, print the reason to stderr and return false
+     * @return true if the socket is listening, false otherwise
+     */
+    bool listenUnix(const char *path);
+
+    /**
+     * @brief Listen on a loopback TCP port
+     * @param port the port number
+     * @error If the socket cannot be created, print the reason to stderr and return false
+     * @return true if the socket is listening, false otherwise
+     */
+    bool listenTcp(int port);
+
+    /**
+     * @brief Run the event loops
+     * @details Run the event loops until a client sends "END" or a stop is requested. The first event loop runs on the calling thread and accepts the connections. The pending replies are sent before returning, for at most kDrainTimeout milliseconds.
+     * @return 0 if the server stops normally, 1 if an error occurs
+     */
+    int run();
+
+    /**
+     * @brief Request the event loops to stop, used as the handler of SIGINT and SIGTERM
+     */
+    static void requestStop(int) {
+        stop_requested_ = 1;
+    }
+
+private:
+    static const int kMaxEvents = 64; // the maximum number of events handled in one epoll_wait
+    static const size_t kReadChunkSize = 1 << 16; // the size of one read from a client
+    static const size_t kMaxPendingInput = 1 << 20; // the maximum length of an incomplete command line
+    static const int kDrainTimeout = 1000; // the maximum time in milliseconds to send the pending replies when the server stops
+
+    /**
+     * @brief The struct of client
+     * @details The struct of client, including the file descriptor, the incomplete input and the pending output
+     *
+     * @param fd_ The file descriptor of the connection
+     * @param input_ The input which has not formed a complete line yet
+     * @param output_ The output which has not been sent yet
+     * @param writing_ Whether the client is waiting for EPOLLOUT
+     * @param closing_ Whether the client has closed its side, the connection is closed once the output is sent
+     */
+    struct Client {
+        int fd_;
+        std::string input_;
+        OutputBuffer output_;
+        bool writing_;
+        bool closing_;
+
+        explicit Client(int fd) : fd_(fd), writing_(false), closing_(false) {}
+    };
+
+    /**
+     * @brief The struct of event loop
+     * @details The struct of event loop, including its epoll instance, the eventfd to wake it up, and the clients it owns
+     *
+     * @param id_ The id of the event loop, also used as the reader id of the concurrent read path
+     * @param epoll_fd_ The epoll instance
+     * @param wake_fd_ The eventfd to wake up the event loop when the server stops
+     * @param clients_ The map from file descriptor to client, used to close the clients when the server stops
+     * @param clients_mutex_ The lock of clients_, since the clients are accepted on the thread of the first event loop
+     * @param buffer_ The buffer of reading
+     */
+    struct EventLoop {
+        int id_;
+        int epoll_fd_;
+        int wake_fd_;
+        std::unordered_map<int, Client *> clients_;
+        std::mutex clients_mutex_;
+        char buffer_[kReadChunkSize];
+
+        explicit EventLoop(int id) : id_(id), epoll_fd_(-1), wake_fd_(-1), buffer_() {}
+    };
+
+    static volatile sig_atomic_t stop_requested_; // whether a stop is requested by a signal
+
+    ICPCManagementSystem &system_; // the system to execute the commands
+    std::mutex system_mutex_; // the lock of executing a command which is not answered by the concurrent read path
+    bool concurrent_reads_; // whether the concurrent read path is enabled
+    int listen_fd_; // the listening socket
+    int next_loop_; // the event loop to assign the next client to
+    std::atomic<bool> ended_; // whether a client has sent "END", or a stop is requested
+    std::string unix_path_; // the path of the Unix domain socket, empty if listening on TCP
+    std::vector<EventLoop *> loops_; // the event loops
+
+    /**
+     * @brief Create the epoll instances and register the listening socket to the first one
+     * @return true if succeeded, false otherwise
+     */
+    bool setUpEpoll();
+
+    /**
+     * @brief Run an event loop until the server stops, then send the pending replies of its clients
+     * @param loop the event loop
+     * @return 0 if the event loop stops normally, 1 if an error occurs
+     */
+    int runLoop(EventLoop *loop);
+
+    /**
+     * @brief Send the pending replies of the clients of a stopped event loop
+     * @details The sockets stay non-blocking, and the clients which cannot take more are polled for POLLOUT until all the replies are sent or kDrainTimeout passes, after which the rest is dropped
+     * @param pending the clients with pending output, emptied of the clients whose replies are sent
+     */
+    static void drainClients(std::vector<Client *> &pending);
+
+    /**
+     * @brief Send the pending output of a client without blocking
+     * @param client the client
+     * @return true if the output is sent or the connection is broken, false if the socket cannot take more now
+     */
+    static bool sendPending(Client *client);
+
+    /**
+     * @brief Stop all the event loops
+     */
+    void stopLoops();
+
+    /**
+     * @brief Accept all the pending connections, and assign them to the event loops in turn
+     */
+    void acceptClients();
+
+    /**
+     * @brief Read the input of a client, and execute the complete command lines
+     * @param loop the event loop owning the client
+     * @param client the client
+     */
+    void readClient(EventLoop *loop, Client *client);
+
+    /**
+     * @brief Execute a command line of a client
+     * @details Answer it by the concurrent read path if possible, otherwise execute it under the lock
+     * @param loop the event loop owning the client
+     * @param client the client
+     * @param line the command line
+     */
+    void executeCommand(EventLoop *loop, Client *client, const char *line);
+
+    /**
+     * @brief Send the pending output of a client as much as possible
+     * @details If the output cannot be sent completely, wait for EPOLLOUT. If the client has closed its side and the output is sent, close the connection.
+     * @param loop the event loop owning the client
+     * @param client the client
+     */
+    void writeClient(EventLoop *loop, Client *client);
+
+    /**
+     * @brief Close the connection of a client
+     * @param loop the event loop owning the client
+     * @param client the client
+     */
+    static void closeClient(EventLoop *loop, Client *client);
+
+    /**
+     * @brief Set a file descriptor to non-blocking mode
+     * @return true if succeeded, false otherwise
+     */
+    static bool setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    }
+};
+
+#endif //ACM_ICPC_MANAGEMENT_SOCKET_SERVER_H
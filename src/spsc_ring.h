@@ -0,0 +1,203 @@
+#ifndef ACM_ICPC_MANAGEMENT_SPSC_RING_H
+#define ACM_ICPC_MANAGEMENT_SPSC_RING_H
+
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <linux/membarrier.h>
+
+/**
+ * @brief The class of single-producer single-consumer ring buffer
+ * @details The class of lock-free ring buffer connecting two threads, one pushing and the other popping.
+ * The producer waits when the ring is full, and the consumer waits when it is empty, so the items are passed in order without loss.
+ * A waiting side yields for kSpinCount rounds, then raises its sleeping flag and sleeps on it with a futex, and the other side wakes it up after moving its index, so an idle stage does not hold a core.
+ * The flag and the index are ordered by an asymmetric fence: the side going to sleep runs membarrier, which fences the other thread too, so pushing and popping only need a compiler fence. Without membarrier, both sides run a full fence.
+ * Each side caches the index of the other side, so the shared indices are only read when the cached one says the ring is full or empty.
+ *
+ * @tparam T the type of the items
+ */
+template<typename T>
+class SpscRing {
+public:
+    /**
+     * @brief Construct a new SpscRing object
+     * @param capacity the capacity of the ring, rounded up to a power of 2
+     */
+    explicit SpscRing(size_t capacity) : mask_(0), items_(nullptr), asymmetric_(registerMembarrier()), head_(0),
+                                         cached_tail_(0), producer_sleeping_(0), tail_(0), cached_head_(0),
+                                         consumer_sleeping_(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        items_ = new T[size];
+    }
+
+    SpscRing(const SpscRing &) = delete;
+
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    ~SpscRing() {
+        delete[] items_;
+    }
+
+    /**
+     * @brief Get the slot of the next item, waiting until the ring is not full. Only called by the producer.
+     * @details The item is not visible to the consumer until commitPush is called, so it can be filled in place.
+     */
+    T &beginPush() {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        for (int spin = 0; tail - cached_head_ > mask_; ++spin) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ <= mask_) {
+                break;
+            }
+            if (spin < kSpinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            // the flag is raised before the head is checked again, so the consumer either sees it or is seen
+            producer_sleeping_.store(1, std::memory_order_relaxed);
+            heavyFence();
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ > mask_) {
+                sleepOn(producer_sleeping_);
+            }
+            producer_sleeping_.store(0, std::memory_order_relaxed);
+        }
+        return items_[tail & mask_];
+    }
+
+    /**
+     * @brief Make the item got by beginPush visible to the consumer. Only called by the producer.
+     */
+    void commitPush() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        lightFence();
+        wakeUp(consumer_sleeping_);
+    }
+
+    /**
+     * @brief Push an item, waiting until the ring is not full. Only called by the producer.
+     */
+    void push(const T &item) {
+        beginPush() = item;
+        commitPush();
+    }
+
+    /**
+     * @brief Get the next item, waiting until the ring is not empty. Only called by the consumer.
+     * @details The slot is not reused by the producer until commitPop is called, so it can be read in place.
+     */
+    const T &beginPop() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        for (int spin = 0; head == cached_tail_; ++spin) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head != cached_tail_) {
+                break;
+            }
+            if (spin < kSpinCount) {
+                std::this_thread::yield();
+                continue;
+            }
+            // the flag is raised before the tail is checked again, so the producer either sees it or is seen
+            consumer_sleeping_.store(1, std::memory_order_relaxed);
+            heavyFence();
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                sleepOn(consumer_sleeping_);
+            }
+            consumer_sleeping_.store(0, std::memory_order_relaxed);
+        }
+        return items_[head & mask_];
+    }
+
+    /**
+     * @brief Check whether the ring is empty. Only called by the consumer.
+     */
+    bool empty() {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        return head == cached_tail_;
+    }
+
+    /**
+     * @brief Release the item got by beginPop. Only called by the consumer.
+     */
+    void commitPop() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        lightFence();
+        wakeUp(producer_sleeping_);
+    }
+
+private:
+    static const int kSpinCount = 1 << 10; // the number of yields before a waiting side sleeps
+    static_assert(sizeof(std::atomic<int>) == sizeof(int), "a sleeping flag is a futex word");
+
+    size_t mask_; // the capacity - 1
+    T *items_; // the items
+    bool asymmetric_; // whether the sleeping side fences the other side by membarrier
+    alignas(64) std::atomic<size_t> head_; // the index of the next item to pop, written by the consumer
+    size_t cached_tail_; // the tail last seen by the consumer
+    std::atomic<int> producer_sleeping_; // whether the producer sleeps on a full ring, only raised by the producer
+    alignas(64) std::atomic<size_t> tail_; // the index of the next item to push, written by the producer
+    size_t cached_head_; // the head last seen by the producer
+    std::atomic<int> consumer_sleeping_; // whether the consumer sleeps on an empty ring, only raised by the consumer
+
+    /**
+     * @brief Register the process for the expedited membarrier once
+     * @return true if membarrier can be used by heavyFence
+     */
+    static bool registerMembarrier() {
+        static const bool registered = syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+        return registered;
+    }
+
+    /**
+     * @brief The fence between moving an index and reading the sleeping flag of the other side
+     */
+    void lightFence() const {
+        if (asymmetric_) {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    /**
+     * @brief The fence between raising the sleeping flag and reading the index of the other side
+     */
+    void heavyFence() const {
+        if (asymmetric_) {
+            syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    /**
+     * @brief Sleep until the flag is lowered by wakeUp, or return at once if it already is
+     */
+    static void sleepOn(std::atomic<int> &flag) {
+        syscall(SYS_futex, reinterpret_cast<int *>(&flag), FUTEX_WAIT_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+
+    /**
+     * @brief Lower the flag and wake the other side up if it is sleeping on it
+     * @details Called after the index is moved, so a side which raised the flag before the move is woken up, and a side which raises it after sees the move
+     */
+    static void wakeUp(std::atomic<int> &flag) {
+        if (flag.load(std::memory_order_relaxed) != 0) {
+            flag.store(0, std::memory_order_relaxed);
+            syscall(SYS_futex, reinterpret_cast<int *>(&flag), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+    }
+};
+
+#endif //ACM_ICPC_MANAGEMENT_SPSC_RING_H
@@ -0,0 +1,131 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <sched.h>
+
+ThreadPool::ThreadPool(int threads) : thread_count_(std::max(1, threads)), deques_(new Deque[thread_count_]),
+                                      generation_(0), stopping_(false), body_(nullptr), context_(nullptr),
+                                      count_(0), grain_(1), pending_(0) {
+    for (int i = 1; i < thread_count_; ++i) {
+        workers_.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+    delete[] deques_;
+}
+
+int ThreadPool::getCoreCount() {
+    cpu_set_t cores;
+    if (sched_getaffinity(0, sizeof(cores), &cores) == 0) {
+        return std::max(1, CPU_COUNT(&cores));
+    }
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void ThreadPool::run(int count, int grain, Body body, void *context) {
+    const int tasks = (count + grain - 1) / grain;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        body_ = body;
+        context_ = context;
+        count_ = count;
+        grain_ = grain;
+        pending_.store(tasks, std::memory_order_relaxed);
+        // a worker still stealing from the previous parallel for may look at the deques, so they are filled under their locks
+        for (int i = 0; i < thread_count_; ++i) {
+            std::lock_guard<std::mutex> deque_lock(deques_[i].mutex_);
+            deques_[i].begin_ = static_cast<int>(static_cast<long long>(tasks) * i / thread_count_);
+            deques_[i].end_ = static_cast<int>(static_cast<long long>(tasks) * (i + 1) / thread_count_);
+        }
+        ++generation_;
+    }
+    wake_.notify_all();
+    runTasks(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] {
+        return pending_.load(std::memory_order_acquire) == 0;
+    });
+}
+
+void ThreadPool::work(int index) {
+    unsigned long long generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this, generation] {
+                return stopping_ || generation_ != generation;
+            });
+            if (stopping_) {
+                return;
+            }
+            generation = generation_;
+        }
+        runTasks(index);
+    }
+}
+
+void ThreadPool::runTasks(int index) {
+    Deque &deque = deques_[index];
+    while (true) {
+        int task;
+        {
+            std::lock_guard<std::mutex> lock(deque.mutex_);
+            task = deque.begin_ < deque.end_ ? deque.begin_++ : -1;
+        }
+        if (task >= 0) {
+            runTask(task);
+            continue;
+        }
+        int begin, end;
+        if (!steal(index, begin, end)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(deque.mutex_);
+            if (deque.begin_ >= deque.end_) {
+                // the stolen tasks can be stolen again from here
+                deque.begin_ = begin;
+                deque.end_ = end;
+                continue;
+            }
+        }
+        // a worker still stealing when the next parallel for starts finds its deque refilled, and runs the stolen tasks itself
+        for (task = begin; task < end; ++task) {
+            runTask(task);
+        }
+    }
+}
+
+void ThreadPool::runTask(int task) {
+    // the task was dealt out after body_ was set, and the parallel for cannot end before it is done
+    int begin = task * grain_;
+    body_(context_, begin, std::min(count_, begin + grain_));
+    if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_one();
+    }
+}
+
+bool ThreadPool::steal(int index, int &begin, int &end) {
+    for (int i = 1; i < thread_count_; ++i) {
+        Deque &victim = deques_[(index + i) % thread_count_];
+        std::lock_guard<std::mutex> lock(victim.mutex_);
+        int remaining = victim.end_ - victim.begin_;
+        if (remaining > 0) {
+            end = victim.end_;
+            begin = end - (remaining + 1) / 2;
+            victim.end_ = begin;
+            return true;
+        }
+    }
+    return false;
+}
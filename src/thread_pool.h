@@ -0,0 +1,136 @@
+#ifndef ACM_ICPC_MANAGEMENT_THREAD_POOL_H
+#define ACM_ICPC_MANAGEMENT_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The class of thread pool
+ * @details The class of work-stealing thread pool running the bulk phases of the engine, made of the calling thread and a few worker threads which sleep between the phases.
+ * A parallel for splits the indices into tasks of a grain of indices, and deals the tasks out to the deques of the threads in contiguous ranges, so each thread starts on a part of the indices of its own.
+ * A thread takes the tasks from the front of its deque, and when it runs out, it steals the back half of the deque of another thread, so a slow range is shared by the idle threads.
+ * The deque of a thread only holds a range of tasks, since a task never creates another one, and it is locked by a mutex, which is taken once per task.
+ * A pool of one thread has no worker, and runs the function on the calling thread at once.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Construct a new ThreadPool object
+     * @param threads the number of threads, including the calling thread, at least 1
+     */
+    explicit ThreadPool(int threads);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Destroy the ThreadPool object
+     * @details Wake the workers up and wait for them to exit
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Get the number of threads, including the calling thread
+     */
+    int size() const {
+        return thread_count_;
+    }
+
+    /**
+     * @brief Get the number of cores the process can run on
+     * @details Count the cores in the CPU affinity mask, since std::thread::hardware_concurrency counts all the cores of the machine even if the process is limited to a few of them
+     * @return The number of cores, at least 1
+     */
+    static int getCoreCount();
+
+    /**
+     * @brief Run a function on the indices in [0, count) with the threads of the pool
+     * @details The function is called once for each task, with the beginning and the end of its indices, and the call returns when all the tasks are done.
+     * It only runs on the calling thread if there is only one thread or one task. It must not be called by the function, nor by two threads at the same time.
+     *
+     * @param count the number of indices
+     * @param grain the number of indices in a task, at least 1
+     * @param function the function called with the beginning and the end of a task
+     */
+    template<typename Function>
+    void parallelFor(int count, int grain, Function function) {
+        if (count <= 0) {
+            return;
+        }
+        if (thread_count_ <= 1 || count <= grain) {
+            function(0, count);
+            return;
+        }
+        run(count, grain, [](void *context, int begin, int end) {
+            (*static_cast<Function *>(context))(begin, end);
+        }, &function);
+    }
+
+private:
+    using Body = void (*)(void *, int, int);
+
+    /**
+     * @brief The struct of the deque of a thread
+     * @details The tasks in [begin_, end_) of the current parallel for. Each one takes a cache line to avoid false sharing.
+     *
+     * @param mutex_ The lock of the deque
+     * @param begin_ The first task, taken by the owner
+     * @param end_ The task after the last one, from which the other threads steal
+     */
+    struct alignas(64) Deque {
+        std::mutex mutex_;
+        int begin_ = 0;
+        int end_ = 0;
+    };
+
+    int thread_count_; // the number of threads, including the calling thread
+    Deque *deques_; // the deques of the threads, the first one is the calling thread's
+    std::vector<std::thread> workers_; // the worker threads
+    std::mutex mutex_; // the lock of generation_ and stopping_, and of the wait for the end of a parallel for
+    std::condition_variable wake_; // the workers wait on it for the next parallel for
+    std::condition_variable done_; // the calling thread waits on it for the last task
+    unsigned long long generation_; // the number of parallel fors started, a worker runs the tasks when it changes
+    bool stopping_; // whether the pool is being destroyed
+    Body body_; // the function of the current parallel for
+    void *context_; // the context of body_
+    int count_; // the number of indices of the current parallel for
+    int grain_; // the number of indices in a task of the current parallel for
+    std::atomic<int> pending_; // the number of tasks of the current parallel for not done yet
+
+    /**
+     * @brief Deal out the tasks, wake the workers up, run the tasks on the calling thread too, and wait for the end
+     */
+    void run(int count, int grain, Body body, void *context);
+
+    /**
+     * @brief The loop of a worker, which sleeps until a parallel for starts, and runs its tasks
+     * @param index the index of the deque of the worker
+     */
+    void work(int index);
+
+    /**
+     * @brief Run the tasks of the deque of a thread, and steal from the other deques when it is empty, until no task is left
+     * @param index the index of the deque of the thread
+     */
+    void runTasks(int index);
+
+    /**
+     * @brief Run a task, and wake the calling thread up if it is the last one
+     */
+    void runTask(int task);
+
+    /**
+     * @brief Take the back half of the tasks of another deque
+     * @param index the index of the deque of the thread stealing
+     * @param begin the first task taken
+     * @param end the task after the last one taken
+     * @return false if every other deque is empty
+     */
+    bool steal(int index, int &begin, int &end);
+};
+
+#endif //ACM_ICPC_MANAGEMENT_THREAD_POOL_H
@@ -4,10 +4,10 @@
 # id=1 && ./cmake-build-debug/ACM_ICPC_Management < ./data/$id.in > ./data/output.txt && diff -uZB ./data/$id.out ./data/output.txt > ./data/diff.txt
 
 # the names of the test cases are:
-# 1.in, 2.in, 3.in, 4.in, 5.in, 6.in, 7.in, small.in, big.in, bigger.in, error.in, test.in
+# 1.in, 2.in, 3.in, 4.in, 5.in, 6.in, 7.in, small.in, big.in, bigger.in, error.in, test.in, history.in, top.in, range.in, query_history.in, analyze.in, problem_stats.in, delta.in
 
 # now test all of them
-for id in 1 2 3 4 5 6 7 small big bigger error test
+for id in 1 2 3 4 5 6 7 small big bigger error test history top range query_history analyze problem_stats delta
 do
     ./cmake-build-debug/ACM_ICPC_Management < ./data/$id.in > ./data/output.txt
     diff -uZB ./data/$id.out ./data/output.txt > ./data/diff.txt
@@ -19,4 +19,15 @@ do
         # stop the script if one test case failed
         exit 1
     fi
-done
\ No newline at end of file
+done
+
+# the delta stream of delta.in is compared with delta.delta
+./cmake-build-debug/ACM_ICPC_Management --delta ./data/delta_output.txt < ./data/delta.in > ./data/output.txt
+diff -uZB ./data/delta.delta ./data/delta_output.txt > ./data/diff.txt
+if [ $? -eq 0 ]
+then
+    echo "test case delta stream passed"
+else
+    echo "test case delta stream failed"
+    exit 1
+fi